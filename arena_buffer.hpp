@@ -0,0 +1,218 @@
+// Circular buffer of variable-size payloads backed by a FIFO arena for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_ARENA_BUFFER
+#define CIRCULAR_BUFFER_ARENA_BUFFER
+
+#include "circular_buffer.hpp"
+
+#include <cstring>
+#include <span>
+
+namespace anr
+{
+
+  template< class T, class Allocator = std::allocator< T > >
+  class arena_buffer
+  {
+    static_assert(std::is_trivially_copyable_v< T >, "The payload elements of an arena_buffer must be trivially copyable");
+
+   public:
+    typedef T                                                          element_type;
+    typedef std::span< T >                                             value_type;
+    typedef std::span< const T >                                       const_value_type;
+    typedef Allocator                                                  allocator_type;
+    typedef std::size_t                                                size_type;
+    typedef typename std::allocator_traits< Allocator >::pointer       pointer;
+
+
+   private:
+    struct record
+    {
+      size_type offset;
+      size_type length;
+    };
+
+    typedef typename std::allocator_traits< Allocator >::template rebind_alloc< record > record_allocator;
+
+    static constexpr size_type npos = std::numeric_limits< size_type >::max();
+
+    allocator_type _allocator;
+    pointer _arena;
+    size_type _arena_capacity;
+    circular_buffer< record, record_allocator > _records;
+
+    // The arena is used in FIFO order: the payloads live between the offset of the
+    // oldest record (back) and the end of the newest one (front), possibly wrapped.
+    size_type _allocate(size_type count) const noexcept
+    {
+      if(_records.empty()) {
+        return count <= _arena_capacity ? 0 : npos;
+      }
+      const size_type head = _records.back().offset;
+      const size_type tail = _records.front().offset + _records.front().length;
+      if(head < tail) {
+        if(_arena_capacity - tail >= count) {
+          return tail;
+        }
+        return head >= count ? 0 : npos;
+      }
+      return head - tail >= count ? tail : npos;
+    }
+
+    static void check_length_error(size_type count, size_type arena_capacity)
+    {
+      if(count > arena_capacity) {
+        char buffer[256];
+        std::snprintf(buffer, 256, "The payload size %lu exceeds the arena capacity (%lu)", count, arena_capacity);
+        throw std::length_error(buffer);
+      }
+    }
+
+
+   public:
+    explicit arena_buffer(size_type capacity, size_type arena_capacity, const allocator_type& alloc = allocator_type())
+      : _allocator(alloc)
+      , _arena(_allocator.allocate(arena_capacity))
+      , _arena_capacity(arena_capacity)
+      , _records(record_allocator(_allocator))
+    {
+      assert(( capacity != 0 ));
+      _records.reserve(capacity);
+    }
+
+    arena_buffer(const arena_buffer& other) = delete;
+    arena_buffer& operator=(const arena_buffer& other) = delete;
+
+    ~arena_buffer()
+    {
+      _allocator.deallocate(_arena, _arena_capacity);
+    }
+
+    allocator_type get_allocator() const noexcept
+    {
+      return _allocator;
+    }
+
+    // Element access
+
+    value_type operator[](size_type pos) noexcept
+    {
+      const record& r = _records[pos];
+      return value_type(&_arena[r.offset], r.length);
+    }
+
+    const_value_type operator[](size_type pos) const noexcept
+    {
+      const record& r = _records[pos];
+      return const_value_type(&_arena[r.offset], r.length);
+    }
+
+    value_type front() noexcept
+    {
+      return operator[](0);
+    }
+
+    const_value_type front() const noexcept
+    {
+      return operator[](0);
+    }
+
+    value_type back() noexcept
+    {
+      return operator[](_records.size()-1);
+    }
+
+    const_value_type back() const noexcept
+    {
+      return operator[](_records.size()-1);
+    }
+
+    // Capacity
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _records.empty();
+    }
+
+    size_type size() const noexcept
+    {
+      return _records.size();
+    }
+
+    size_type capacity() const noexcept
+    {
+      return _records.capacity();
+    }
+
+    size_type arena_capacity() const noexcept
+    {
+      return _arena_capacity;
+    }
+
+    // Modifiers
+
+    void clear() noexcept
+    {
+      _records.clear();
+    }
+
+    void push_back(const T* data, size_type count)
+    {
+      check_length_error(count, _arena_capacity);
+      size_type offset = _allocate(count);
+      while(offset == npos || _records.size() == _records.capacity()) {
+        _records.pop_back();
+        offset = _allocate(count);
+      }
+      if(count != 0) {
+        std::memcpy(&_arena[offset], data, count * sizeof(T));
+      }
+      _records.push_back(record{offset, count});
+    }
+
+    void push_back(const_value_type payload)
+    {
+      push_back(payload.data(), payload.size());
+    }
+
+    void pop_front()
+    {
+      _records.pop_front();
+    }
+
+    void pop_back()
+    {
+      _records.pop_back();
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_ARENA_BUFFER
@@ -0,0 +1,229 @@
+// Byte stream over a circular buffer for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_BYTE_STREAM
+#define CIRCULAR_BUFFER_BYTE_STREAM
+
+#include "circular_buffer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <string_view>
+#include <vector>
+
+namespace anr
+{
+
+  // Reads go through the two contiguous segments of the circular buffer, the oldest byte being
+  // the first of the stream. A peek only copies into the scratch when it straddles the wrap.
+  template< class Allocator = std::allocator< char > >
+  class byte_stream
+  {
+   public:
+    typedef char              value_type;
+    typedef Allocator         allocator_type;
+    typedef std::size_t       size_type;
+
+    static constexpr size_type npos = std::numeric_limits< size_type >::max();
+
+
+   private:
+    circular_buffer< char, Allocator > _ring;
+    mutable std::vector< char > _scratch;
+
+    // Copies count bytes from offset to out.
+    void _copy(size_type offset, size_type count, char* out) const noexcept
+    {
+      const std::span< const char > one = _ring.array_one();
+      const std::span< const char > two = _ring.array_two();
+      if(offset < one.size()) {
+        const size_type run = std::min(count, one.size() - offset);
+        std::memcpy(out, one.data() + offset, run);
+        out += run;
+        count -= run;
+        offset = 0;
+      }
+      else {
+        offset -= one.size();
+      }
+      std::memcpy(out, two.data() + offset, count);
+    }
+
+    template< class T, std::endian Order >
+    T _peek(size_type offset) const noexcept
+    {
+      assert(( offset <= size() && sizeof(T) <= size() - offset ));
+      char bytes[sizeof(T)];
+      _copy(offset, sizeof(T), bytes);
+      if constexpr(Order != std::endian::native) {
+        std::reverse(bytes, bytes + sizeof(T));
+      }
+      T value;
+      std::memcpy(&value, bytes, sizeof(T));
+      return value;
+    }
+
+
+   public:
+    explicit byte_stream(size_type capacity, const Allocator& alloc = Allocator())
+      : _ring(alloc)
+      , _scratch()
+    {
+      _ring.reserve(capacity);
+    }
+
+    // Element access
+
+    // Returns a contiguous view of the n first bytes, valid until the next modification of the
+    // stream or the next peek.
+    std::string_view peek(size_type n) const
+    {
+      assert(( n <= size() ));
+      const std::span< const char > one = _ring.array_one();
+      if(n <= one.size()) {
+        return std::string_view(one.data(), n);
+      }
+      if(_scratch.size() < n) {
+        _scratch.resize(n);
+      }
+      _copy(0, n, _scratch.data());
+      return std::string_view(_scratch.data(), n);
+    }
+
+    template< class T > requires std::is_arithmetic_v< T >
+    T peek_le(size_type offset = 0) const noexcept
+    {
+      return _peek< T, std::endian::little >(offset);
+    }
+
+    template< class T > requires std::is_arithmetic_v< T >
+    T peek_be(size_type offset = 0) const noexcept
+    {
+      return _peek< T, std::endian::big >(offset);
+    }
+
+    // Returns the offset of the first occurrence of delimiter at or after from, or npos.
+    size_type find(char delimiter, size_type from = 0) const noexcept
+    {
+      const std::span< const char > one = _ring.array_one();
+      const std::span< const char > two = _ring.array_two();
+      if(from < one.size()) {
+        if(const void* found = std::memchr(one.data() + from, delimiter, one.size() - from)) {
+          return static_cast< const char* >(found) - one.data();
+        }
+        from = one.size();
+      }
+      if(from < size()) {
+        const size_type offset = from - one.size();
+        if(const void* found = std::memchr(two.data() + offset, delimiter, two.size() - offset)) {
+          return one.size() + (static_cast< const char* >(found) - two.data());
+        }
+      }
+      return npos;
+    }
+
+    // The segments holding the bytes, from the first one.
+    std::span< const char > array_one() const noexcept
+    {
+      return _ring.array_one();
+    }
+
+    std::span< const char > array_two() const noexcept
+    {
+      return _ring.array_two();
+    }
+
+    // Capacity
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _ring.empty();
+    }
+
+    size_type size() const noexcept
+    {
+      return _ring.size();
+    }
+
+    size_type capacity() const noexcept
+    {
+      return _ring.capacity();
+    }
+
+    size_type available() const noexcept
+    {
+      return _ring.capacity() - _ring.size();
+    }
+
+    // Modifiers
+
+    // Appends at most available() bytes of data and returns their number.
+    size_type write(const char* data, size_type n)
+    {
+      n = std::min(n, available());
+      _ring.push_back_n(data, n);
+      return n;
+    }
+
+    size_type write(std::string_view data)
+    {
+      return write(data.data(), data.size());
+    }
+
+    void consume(size_type n)
+    {
+      assert(( n <= size() ));
+      _ring.pop_back_n(n);
+    }
+
+    template< class T > requires std::is_arithmetic_v< T >
+    T read_le()
+    {
+      const T value = peek_le< T >();
+      consume(sizeof(T));
+      return value;
+    }
+
+    template< class T > requires std::is_arithmetic_v< T >
+    T read_be()
+    {
+      const T value = peek_be< T >();
+      consume(sizeof(T));
+      return value;
+    }
+
+    void clear() noexcept
+    {
+      _ring.clear();
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_BYTE_STREAM
@@ -34,13 +34,106 @@
 #define CIRCULAR_BUFFER_VERSION_PATCH 0 // for backwards-compatible bug fixes
 
 #include <cassert>
+#include <concepts>
+#include <cstdint>
 #include <cstdio>
+#include <cstring>
+#include <iterator>
 #include <limits>
 #include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CIRCULAR_BUFFER_SSE2
+#endif
+
+// Distance, in bytes, at which the bulk operations prefetch the elements ahead of the current one.
+#ifndef CIRCULAR_BUFFER_PREFETCH_DISTANCE
+#define CIRCULAR_BUFFER_PREFETCH_DISTANCE 512
+#endif
 
 namespace anr
 {
 
+  // Tag selecting the non-temporal variant of the bulk operations, which bypass the caches
+  // for data that will not be read again soon.
+  struct non_temporal_t
+  {
+    explicit non_temporal_t() = default;
+  };
+  
+  inline constexpr non_temporal_t non_temporal{};
+  
+  // What happens when pushing into a full container built on a circular buffer.
+  enum class overrun_policy
+  {
+    block,    // pushing fails and does nothing
+    overwrite // pushing overwrites the oldest element
+  };
+  
+  namespace detail
+  {
+    
+    inline void prefetch(const void* address) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      __builtin_prefetch(address, 0, 3);
+#elif defined(CIRCULAR_BUFFER_SSE2)
+      _mm_prefetch(static_cast< const char* >(address), _MM_HINT_T0);
+#else
+      (void)address;
+#endif
+    }
+    
+    inline void prefetch_non_temporal(const void* address) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+      __builtin_prefetch(address, 0, 0);
+#elif defined(CIRCULAR_BUFFER_SSE2)
+      _mm_prefetch(static_cast< const char* >(address), _MM_HINT_NTA);
+#else
+      (void)address;
+#endif
+    }
+    
+    // Copies with non-temporal stores when available, falls back to std::memcpy otherwise.
+    inline void stream_copy(void* destination, const void* source, std::size_t bytes) noexcept
+    {
+#ifdef CIRCULAR_BUFFER_SSE2
+      char* dst = static_cast< char* >(destination);
+      const char* src = static_cast< const char* >(source);
+      const std::size_t head = (16 - (reinterpret_cast< std::uintptr_t >(dst) & 15)) & 15;
+      if(bytes < head + 64) {
+        std::memcpy(dst, src, bytes);
+        return;
+      }
+      std::memcpy(dst, src, head);
+      dst += head;
+      src += head;
+      bytes -= head;
+      for(; bytes >= 64; bytes -= 64, dst += 64, src += 64) {
+        prefetch_non_temporal(src + CIRCULAR_BUFFER_PREFETCH_DISTANCE);
+        const __m128i a = _mm_loadu_si128(reinterpret_cast< const __m128i* >(src));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast< const __m128i* >(src + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast< const __m128i* >(src + 32));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast< const __m128i* >(src + 48));
+        _mm_stream_si128(reinterpret_cast< __m128i* >(dst), a);
+        _mm_stream_si128(reinterpret_cast< __m128i* >(dst + 16), b);
+        _mm_stream_si128(reinterpret_cast< __m128i* >(dst + 32), c);
+        _mm_stream_si128(reinterpret_cast< __m128i* >(dst + 48), d);
+      }
+      _mm_sfence();
+      std::memcpy(dst, src, bytes);
+#else
+      std::memcpy(destination, source, bytes);
+#endif
+    }
+    
+  }
+
   template< class T, class Allocator = std::allocator<T> >
   class circular_buffer
   {
@@ -60,6 +153,9 @@ namespace anr
     typedef circular_buffer_iterator<const T>                          const_iterator;
     typedef std::reverse_iterator< iterator >                          reverse_iterator;
     typedef std::reverse_iterator< const_iterator >                    const_reverse_iterator;
+    typedef std::uint64_t                                              sequence_type;
+    
+    class handle;
     
     
    private:
@@ -68,6 +164,7 @@ namespace anr
     size_type _index;
     size_type _size;
     size_type _capacity;
+    sequence_type _sequence; // sequence number of the next pushed element, never decreasing
     
     static void check_length_error(size_type new_cap, size_type max_size)
     {
@@ -87,6 +184,45 @@ namespace anr
       }
     }
     
+    void check_valid(handle h) const
+    {
+      if(!is_valid(h)) {
+        char buffer[256];
+        std::snprintf(buffer, 256, "The sequence number %llu is not in the circular buffer", static_cast< unsigned long long >(h.sequence()));
+        throw std::out_of_range(buffer);
+      }
+    }
+    
+    constexpr size_type _slot(size_type pos) const noexcept
+    {
+      return (_index + _capacity - pos) % _capacity;
+    }
+    
+    // The sequence number of the element at position pos is _sequence - 1 - pos. The operations
+    // that cannot keep this numbering without reusing the sequence number of a removed element
+    // give new ones to all the elements, greater than any sequence number given before, so that
+    // the handles of the former elements are detected as invalid.
+    constexpr void _renumber() noexcept
+    {
+      _sequence += _size;
+    }
+    
+    void _copy_slots(const circular_buffer& other)
+    {
+      for(size_type i = 0; i < other._size; ++i) {
+        const size_type slot = other._slot(i);
+        _construct(slot, other._buffer[slot]);
+      }
+    }
+    
+    void _move_slots(circular_buffer& other)
+    {
+      for(size_type i = 0; i < other._size; ++i) {
+        const size_type slot = other._slot(i);
+        _construct(slot, std::move(other._buffer[slot]));
+      }
+    }
+    
     void _set_invalid()
     {
       _buffer = nullptr;
@@ -103,25 +239,241 @@ namespace anr
       _set_invalid();
     }
     
+    // Allocators may provide a realloc-like member function preserving the content of the storage.
+    static constexpr bool _can_reallocate = std::is_trivially_copyable_v< value_type > && requires(allocator_type& a, pointer p, size_type n) {
+      { a.reallocate(p, n, n) } -> std::convertible_to< pointer >;
+    };
+    
+    // Allocators may also be notified of the storage freed by the consumption of the oldest elements.
+    static constexpr bool _can_discard = requires(allocator_type& a, pointer p) {
+      a.discard(p, p, p);
+    };
+    
+    static constexpr size_type _prefetch_distance = CIRCULAR_BUFFER_PREFETCH_DISTANCE / sizeof(value_type) != 0 ? CIRCULAR_BUFFER_PREFETCH_DISTANCE / sizeof(value_type) : 1;
+    
+    // [slot, slot + count) has just been consumed and is contiguous.
+    void _discard(size_type slot, size_type count)
+    {
+      if constexpr(_can_discard) {
+        const size_type first = slot > _index ? _index + 1 : 0;
+        _allocator.discard(&_buffer[first], &_buffer[slot], &_buffer[slot] + count);
+      }
+    }
+    
+    // Moves the n elements at positions [src, src + n) to positions [dst, dst + n). The ranges
+    // may overlap: the elements are visited in an order that never overwrites a source not yet read.
+    void _move_positions(size_type dst, size_type src, size_type n)
+    {
+      if(n == 0 || dst == src) {
+        return;
+      }
+      if constexpr(std::is_trivially_copyable_v< value_type >) {
+        // The positions grow toward the lower addresses: [src, src + n) starts at the slot of src + n - 1.
+        const size_type s = _slot(src + n - 1);
+        const size_type d = _slot(dst + n - 1);
+        if(dst > src) {
+          for(size_type done = 0; done < n; ) {
+            const size_type from = (s + done) % _capacity;
+            const size_type to = (d + done) % _capacity;
+            size_type run = n - done;
+            run = run < _capacity - from ? run : _capacity - from;
+            run = run < _capacity - to ? run : _capacity - to;
+            std::memmove(&_buffer[to], &_buffer[from], run * sizeof(value_type));
+            done += run;
+          }
+        }
+        else {
+          for(size_type left = n; left != 0; ) {
+            const size_type from = (s + left - 1) % _capacity;
+            const size_type to = (d + left - 1) % _capacity;
+            size_type run = left;
+            run = run < from + 1 ? run : from + 1;
+            run = run < to + 1 ? run : to + 1;
+            std::memmove(&_buffer[to + 1 - run], &_buffer[from + 1 - run], run * sizeof(value_type));
+            left -= run;
+          }
+        }
+      }
+      else {
+        if(dst > src) {
+          for(size_type i = n; i != 0; --i) {
+            operator[](dst + i - 1) = std::move(operator[](src + i - 1));
+          }
+        }
+        else {
+          for(size_type i = 0; i < n; ++i) {
+            operator[](dst + i) = std::move(operator[](src + i));
+          }
+        }
+      }
+    }
+    
+    // Opens a hole at position pos by shifting the shortest side, and returns its slot. The slot
+    // holds a live (moved-from) element, except if the hole is at one end of the buffer. Only a
+    // hole at the newest end, as for a push, keeps the sequence numbers of the elements.
+    size_type _open(size_type pos, bool& constructed)
+    {
+      if(_size == _capacity) {
+        pop_back();
+        pos = pos < _size ? pos : _size;
+      }
+      constructed = false;
+      if(pos <= _size - pos) {
+        _index = (_index + 1) % _capacity;
+        _size ++;
+        if(pos != 0) {
+          std::construct_at(&_buffer[_slot(0)], std::move(operator[](1)));
+          _move_positions(1, 2, pos - 1);
+          constructed = true;
+          _renumber();
+        }
+        else {
+          _sequence ++;
+        }
+      }
+      else if(pos != _size) {
+        std::construct_at(&_buffer[_slot(_size)], std::move(operator[](_size-1)));
+        _size ++;
+        _move_positions(pos + 1, pos, _size - 2 - pos);
+        constructed = true;
+        _renumber();
+      }
+      else {
+        _size ++;
+        _renumber();
+      }
+      return _slot(pos);
+    }
+    
+    // For arithmetic types, the wrap of the index uses a mask instead of a modulo and the size
+    // saturates arithmetically: pushing does not branch on the filling of the buffer.
+    constexpr void _push_back_branchless(value_type value) noexcept
+    {
+      const size_type next = _index + 1;
+      _index = next & (size_type(0) - size_type(next != _capacity));
+      std::construct_at(&_buffer[_index], value);
+      _size += size_type(_size != _capacity);
+      _sequence ++;
+    }
+    
+    template< bool NonTemporal >
+    void _push_back_n(const value_type* src, size_type count)
+    {
+      assert((_capacity != 0));
+      if(count == 0) {
+        return;
+      }
+      _sequence += count;
+      if(count > _capacity) {
+        src += count - _capacity;
+        count = _capacity;
+      }
+      // The written slots follow the newest element, overwriting the oldest ones if needed.
+      const size_type start = (_index + 1) % _capacity;
+      for(size_type done = 0; done < count; ) {
+        const size_type slot = (start + done) % _capacity;
+        const size_type run = count - done < _capacity - slot ? count - done : _capacity - slot;
+        if constexpr(NonTemporal) {
+          detail::stream_copy(&_buffer[slot], src + done, run * sizeof(value_type));
+        }
+        else {
+          std::memcpy(&_buffer[slot], src + done, run * sizeof(value_type));
+        }
+        done += run;
+      }
+      _index = (start + count - 1) % _capacity;
+      _size = _capacity - _size > count ? _size + count : _capacity;
+    }
+    
+    template< bool NonTemporal, class OutputIt >
+    size_type _pop_back_n(OutputIt out, size_type count)
+    {
+      count = count < _size ? count : _size;
+      for(size_type done = 0; done < count; ) {
+        const size_type slot = _slot(_size-1);
+        const size_type run = count - done < _capacity - slot ? count - done : _capacity - slot;
+        pointer src = &_buffer[slot];
+        if constexpr(NonTemporal) {
+          detail::stream_copy(std::to_address(out), src, run * sizeof(value_type));
+          out += run;
+        }
+        else if constexpr(std::is_trivially_copyable_v< value_type > && std::is_same_v< OutputIt, value_type* >) {
+          std::memcpy(out, src, run * sizeof(value_type));
+          out += run;
+        }
+        else {
+          for(size_type i = 0; i < run; ++i) {
+            if(i + _prefetch_distance < run) {
+              detail::prefetch(src + i + _prefetch_distance);
+            }
+            *out = std::move(src[i]);
+            ++out;
+            std::destroy_at(src + i);
+          }
+        }
+        _size -= run;
+        _discard(slot, run);
+        done += run;
+      }
+      return count;
+    }
+    
+    void _grow_in_place(size_type new_cap)
+    {
+      const size_type head = _size != 0 ? _slot(_size-1) : 0;
+      _buffer = _allocator.reallocate(_buffer, _capacity, new_cap);
+      
+      if(_size != 0 && head > _index) {
+        // The buffer is wrapped: only the shortest segment is moved to the new space.
+        const size_type oldest = _capacity - head;
+        const size_type newest = _index + 1;
+        if(newest <= oldest && newest <= new_cap - _capacity) {
+          std::memmove(&_buffer[_capacity], &_buffer[0], newest * sizeof(value_type));
+          _index += _capacity;
+        }
+        else {
+          std::memmove(&_buffer[new_cap - oldest], &_buffer[head], oldest * sizeof(value_type));
+        }
+      }
+      _capacity = new_cap;
+    }
+    
     void _reallocate(size_type new_cap)
     {
       if(_capacity == new_cap) {
         return;
       }
       
+      if constexpr(_can_reallocate) {
+        if(_capacity != 0 && new_cap > _capacity) {
+          _grow_in_place(new_cap);
+          return;
+        }
+      }
+      
       const size_type newSize = _size < new_cap ? _size : new_cap;
       pointer newBuffer = _allocator.allocate(new_cap);
       
-      for(size_type i = 0; i < newSize; ++i) {
-        const size_type pos = newSize - i - 1;
-        std::construct_at(&newBuffer[pos], operator[](i));
+      // The kept elements are moved in chronological order, the oldest one at the beginning of the new storage.
+      if constexpr(std::is_trivially_copyable_v< value_type >) {
+        if(newSize != 0) {
+          const size_type head = _slot(newSize-1);
+          const size_type first = newSize < _capacity - head ? newSize : _capacity - head;
+          std::memcpy(&newBuffer[0], &_buffer[head], first * sizeof(value_type));
+          std::memcpy(&newBuffer[first], &_buffer[0], (newSize - first) * sizeof(value_type));
+        }
+      }
+      else {
+        for(size_type i = 0; i < newSize; ++i) {
+          std::construct_at(&newBuffer[i], std::move(operator[](newSize - i - 1)));
+        }
       }
       
       clear();
       _deallocate();
       
       _buffer = newBuffer;
-      _index = newSize-1;
+      _index = newSize != 0 ? newSize-1 : new_cap-1;
       _capacity = new_cap;
       _size = newSize;
     }
@@ -144,6 +496,7 @@ namespace anr
       , _index(max_size())
       , _size(0)
       , _capacity(0)
+      , _sequence(0)
     {
     }
     
@@ -153,6 +506,7 @@ namespace anr
       , _index(max_size())
       , _size(0)
       , _capacity(0)
+      , _sequence(0)
     {
     }
     
@@ -162,6 +516,7 @@ namespace anr
       , _index(count-1)
       , _size(count)
       , _capacity(count)
+      , _sequence(count)
     {
     }
     
@@ -171,6 +526,7 @@ namespace anr
       , _index(count-1)
       , _size(count)
       , _capacity(count)
+      , _sequence(count)
     {
       for(size_type i = 0; i < count; ++i) {
         _construct(i, value);
@@ -181,13 +537,15 @@ namespace anr
     constexpr circular_buffer(InputIt first, InputIt last, const allocator_type& alloc = allocator_type())
       : _allocator(alloc)
       , _buffer(nullptr)
-      , _index(std::distance(first, last))
-      , _size(_index+1)
+      , _index(0)
+      , _size(std::distance(first, last))
       , _capacity(_size)
+      , _sequence(_size)
     {
       _buffer = _allocator.allocate(_capacity);
+      _index = _capacity - 1;
       size_type i = 0;
-      for(const auto& it = first; it != last; ++it) {
+      for(auto it = first; it != last; ++it) {
         _construct(i, *it);
         i++;
       }
@@ -195,26 +553,24 @@ namespace anr
     
     constexpr circular_buffer(const circular_buffer& other)
       : _allocator(other._allocator)
-      , _buffer(_allocator.allocate(other._size))
+      , _buffer(_allocator.allocate(other._capacity))
       , _index(other._index)
       , _size(other._size)
       , _capacity(other._capacity)
+      , _sequence(other._sequence)
     {
-      for(size_type i = 0; i < _size; ++i) {
-        _construct(i, other._buffer[i]);
-      }
+      _copy_slots(other);
     }
     
     constexpr circular_buffer(const circular_buffer& other, const allocator_type& alloc)
       : _allocator(alloc)
-      , _buffer(_allocator.allocate(other._size))
+      , _buffer(_allocator.allocate(other._capacity))
       , _index(other._index)
       , _size(other._size)
       , _capacity(other._capacity)
+      , _sequence(other._sequence)
     {
-      for(size_type i = 0; i < _size; ++i) {
-        _construct(i, other._buffer[i]);
-      }
+      _copy_slots(other);
     }
     
     constexpr circular_buffer(circular_buffer&& other) noexcept
@@ -223,6 +579,7 @@ namespace anr
       , _index(other._index)
       , _size(other._size)
       , _capacity(other._capacity)
+      , _sequence(other._sequence)
     {
       other._set_invalid();
     }
@@ -233,6 +590,7 @@ namespace anr
       , _index(other._index)
       , _size(other._size)
       , _capacity(other._capacity)
+      , _sequence(other._sequence)
     {
       if(_allocator == other._allocator) {
         _buffer = other._buffer;
@@ -240,9 +598,7 @@ namespace anr
       }
       else {
         _buffer = _allocator.allocate(_capacity);
-        for(size_type i = 0; i < _size; ++i) {
-          _construct(i, std::move(other._buffer[i]));
-        }
+        _move_slots(other);
       }
     }
     
@@ -258,9 +614,8 @@ namespace anr
       _buffer = _allocator.allocate(_capacity);
       _index = other._index;
       _size = other._size;
-      for(size_type i = 0; i < _size; ++i) {
-        _construct(i, other._buffer[i]);
-      }
+      _sequence = other._sequence;
+      _copy_slots(other);
       
       return *this;
     }
@@ -278,6 +633,7 @@ namespace anr
         _index = other._index;
         _size = other._size;
         _capacity = other._capacity;
+        _sequence = other._sequence;
         other._set_invalid();
       }
       else {
@@ -285,9 +641,8 @@ namespace anr
         _buffer = _allocator.allocate(_capacity);
         _index = other._index;
         _size = other._size;
-        for(size_type i = 0; i < _size; ++i) {
-          _construct(i, std::move(other._buffer[i]));
-        }
+        _sequence = other._sequence;
+        _move_slots(other);
       }
       
       return *this;
@@ -309,27 +664,47 @@ namespace anr
     constexpr reference at(size_type pos)
     {
       check_out_of_range(pos, _size);
-      assert(( ((_capacity != _size) && (_index == _size-1)) || (_capacity == _size) ));
-      return _buffer[(_index + _capacity - pos) % _capacity];
+      return _buffer[_slot(pos)];
     }
     
     constexpr const_reference at(size_type pos) const
     {
       check_out_of_range(pos, _size);
-      assert(( ((_capacity != _size) && (_index == _size-1)) || (_capacity == _size) ));
-      return _buffer[(_index + _capacity - pos) % _capacity];
+      return _buffer[_slot(pos)];
     }
     
     constexpr reference operator[](size_type pos) noexcept
     {
-      assert(( ((_capacity != _size) && (_index == _size-1)) || (_capacity == _size) ));
-      return _buffer[(_index + _capacity - pos) % _capacity];
+      return _buffer[_slot(pos)];
     }
     
     constexpr const_reference operator[](size_type pos) const noexcept
     {
-      assert(( ((_capacity != _size) && (_index == _size-1)) || (_capacity == _size) ));
-      return _buffer[(_index + _capacity - pos) % _capacity];
+      return _buffer[_slot(pos)];
+    }
+    
+    constexpr reference at(handle h)
+    {
+      check_valid(h);
+      return operator[](h);
+    }
+    
+    constexpr const_reference at(handle h) const
+    {
+      check_valid(h);
+      return operator[](h);
+    }
+    
+    constexpr reference operator[](handle h) noexcept
+    {
+      assert(( is_valid(h) ));
+      return _buffer[_slot(_sequence - 1 - h.sequence())];
+    }
+    
+    constexpr const_reference operator[](handle h) const noexcept
+    {
+      assert(( is_valid(h) ));
+      return _buffer[_slot(_sequence - 1 - h.sequence())];
     }
     
     constexpr reference front()
@@ -366,6 +741,75 @@ namespace anr
       return &_buffer[0];
     }
     
+    constexpr std::span< value_type > array_one() noexcept
+    {
+      const size_type head = _size != 0 ? _slot(_size-1) : 0;
+      return std::span< value_type >(std::to_address(_buffer) + head, _size < _capacity - head ? _size : _capacity - head);
+    }
+    
+    constexpr std::span< const value_type > array_one() const noexcept
+    {
+      const size_type head = _size != 0 ? _slot(_size-1) : 0;
+      return std::span< const value_type >(std::to_address(_buffer) + head, _size < _capacity - head ? _size : _capacity - head);
+    }
+    
+    constexpr std::span< value_type > array_two() noexcept
+    {
+      return std::span< value_type >(std::to_address(_buffer), _size - array_one().size());
+    }
+    
+    constexpr std::span< const value_type > array_two() const noexcept
+    {
+      return std::span< const value_type >(std::to_address(_buffer), _size - array_one().size());
+    }
+    
+    template< class Function >
+    constexpr void for_each(Function&& function)
+    {
+      const std::span< value_type > one = array_one();
+      const std::span< value_type > two = array_two();
+      // The beginning of the second segment is prefetched before reaching the wrap point.
+      for(size_type i = 0; i < one.size(); ++i) {
+        const size_type ahead = i + _prefetch_distance;
+        if(ahead < one.size()) {
+          detail::prefetch(&one[ahead]);
+        }
+        else if(ahead - one.size() < two.size()) {
+          detail::prefetch(&two[ahead - one.size()]);
+        }
+        function(one[i]);
+      }
+      for(size_type i = 0; i < two.size(); ++i) {
+        if(i + _prefetch_distance < two.size()) {
+          detail::prefetch(&two[i + _prefetch_distance]);
+        }
+        function(two[i]);
+      }
+    }
+    
+    template< class Function >
+    constexpr void for_each(Function&& function) const
+    {
+      const_cast< circular_buffer* >(this)->for_each([&](const_reference value) { function(value); });
+    }
+    
+    // Handles
+    
+    constexpr handle handle_at(size_type pos) const noexcept
+    {
+      return handle(_sequence - 1 - pos);
+    }
+    
+    constexpr bool is_valid(handle h) const noexcept
+    {
+      return _sequence - 1 - h.sequence() < _size;
+    }
+    
+    constexpr sequence_type next_sequence() const noexcept
+    {
+      return _sequence;
+    }
+    
     // Iterators
       
     constexpr iterator begin() noexcept
@@ -467,37 +911,221 @@ namespace anr
     {
       if constexpr(std::is_destructible_v<value_type> && !std::is_trivially_destructible_v<value_type>) {
         for(size_type i = 0; i < _size; ++i) {
-          std::destroy_at(&_buffer[i]);
+          std::destroy_at(&_buffer[_slot(i)]);
         }
       }
-      _index = 0;
+      _index = _capacity - 1;
       _size = 0;
     }
     
     constexpr void push_back(const_reference value)
     {
+      if constexpr(std::is_arithmetic_v< value_type >) {
+        _push_back_branchless(value);
+        return;
+      }
       _index = (_index + 1) % _capacity;
-      _construct(_index, value);
       if(_size != _capacity) {
+        _construct(_index, value);
         _size ++;
       }
+      else {
+        _buffer[_index] = value;
+      }
+      _sequence ++;
     }
     
     constexpr void push_back(T&& value)
     {
+      if constexpr(std::is_arithmetic_v< value_type >) {
+        _push_back_branchless(value);
+        return;
+      }
       _index = (_index + 1) % _capacity;
-      _construct(_index, std::move(value));
       if(_size != _capacity) {
+        _construct(_index, std::move(value));
         _size ++;
       }
+      else {
+        _buffer[_index] = std::move(value);
+      }
+      _sequence ++;
+    }
+    
+    constexpr void push_back_n(const_pointer src, size_type count)
+    {
+      if constexpr(std::is_trivially_copyable_v< value_type >) {
+        _push_back_n< false >(std::to_address(src), count);
+      }
+      else {
+        for(size_type i = 0; i < count; ++i) {
+          push_back(src[i]);
+        }
+      }
+    }
+    
+    constexpr void push_back_n(non_temporal_t, const_pointer src, size_type count) requires std::is_trivially_copyable_v< value_type >
+    {
+      _push_back_n< true >(std::to_address(src), count);
+    }
+    
+    constexpr void pop_front()
+    {
+      assert((_size != 0));
+      std::destroy_at(&_buffer[_index]);
+      if constexpr(std::is_arithmetic_v< value_type >) {
+        _index += _capacity & (size_type(0) - size_type(_index == 0));
+        _index --;
+      }
+      else {
+        _index = (_index + _capacity - 1) % _capacity;
+      }
+      _size --;
+      _renumber();
+    }
+    
+    constexpr void pop_back()
+    {
+      assert((_size != 0));
+      const size_type slot = _slot(_size-1);
+      std::destroy_at(&_buffer[slot]);
+      _size --;
+      _discard(slot, 1);
+    }
+    
+    template< class OutputIt >
+    constexpr size_type pop_back_n(OutputIt out, size_type count)
+    {
+      return _pop_back_n< false >(out, count);
+    }
+    
+    constexpr size_type pop_back_n(non_temporal_t, pointer out, size_type count) requires std::is_trivially_copyable_v< value_type >
+    {
+      return _pop_back_n< true >(out, count);
+    }
+    
+    constexpr size_type pop_back_n(size_type count)
+    {
+      count = count < _size ? count : _size;
+      for(size_type done = 0; done < count; ) {
+        const size_type slot = _slot(_size-1);
+        const size_type run = count - done < _capacity - slot ? count - done : _capacity - slot;
+        std::destroy_n(&_buffer[slot], run);
+        _size -= run;
+        _discard(slot, run);
+        done += run;
+      }
+      return count;
     }
     
     template< class... Args >
     constexpr reference emplace_back(Args&&... args)
     {
+      _index = (_index + 1) % _capacity;
+      if(_size != _capacity) {
+        std::construct_at(&_buffer[_index], std::forward< Args >(args)...);
+        _size ++;
+      }
+      else {
+        _buffer[_index] = value_type(std::forward< Args >(args)...);
+      }
+      _sequence ++;
+      return _buffer[_index];
+    }
+    
+    constexpr iterator insert(const_iterator pos, const_reference value)
+    {
+      return emplace(pos, value);
+    }
+    
+    constexpr iterator insert(const_iterator pos, T&& value)
+    {
+      return emplace(pos, std::move(value));
+    }
+    
+    template< class... Args >
+    constexpr iterator emplace(const_iterator pos, Args&&... args)
+    {
+      assert((_capacity != 0));
       value_type value(std::forward< Args >(args)...);
-      push(std::move(value));
-      return *_buffer[_index];
+      const size_type p = _size == _capacity && pos._offset == _size ? _size - 1 : pos._offset;
+      bool constructed;
+      const size_type slot = _open(pos._offset, constructed);
+      if(constructed) {
+        _buffer[slot] = std::move(value);
+      }
+      else {
+        std::construct_at(&_buffer[slot], std::move(value));
+      }
+      return iterator(*this, p);
+    }
+    
+    constexpr iterator erase(const_iterator pos)
+    {
+      return erase(pos, pos + 1);
+    }
+    
+    // Shifts the shortest of the two sides of the erased range. Only a range ending with the
+    // oldest element, as for a pop_back, keeps the sequence numbers of the remaining elements.
+    constexpr iterator erase(const_iterator first, const_iterator last)
+    {
+      const size_type p = first._offset;
+      const size_type q = last._offset;
+      const size_type n = q - p;
+      if(n == 0) {
+        return iterator(*this, p);
+      }
+      const bool oldest = q == _size;
+      if(p <= _size - q) {
+        _move_positions(n, 0, p);
+        for(size_type i = 0; i < n; ++i) {
+          std::destroy_at(&_buffer[_slot(i)]);
+        }
+        _index = (_index + _capacity - n) % _capacity;
+      }
+      else {
+        _move_positions(p, q, _size - q);
+        for(size_type i = _size - n; i < _size; ++i) {
+          std::destroy_at(&_buffer[_slot(i)]);
+        }
+      }
+      _size -= n;
+      if(!oldest) {
+        _renumber();
+      }
+      return iterator(*this, p);
+    }
+    
+    constexpr void push_front(const_reference value)
+    {
+      emplace_front(value);
+    }
+    
+    constexpr void push_front(T&& value)
+    {
+      emplace_front(std::move(value));
+    }
+    
+    // The new element becomes the oldest one. When the buffer is full, the slot of the newest
+    // element is the one preceding the oldest element: the newest element is overwritten.
+    template< class... Args >
+    constexpr reference emplace_front(Args&&... args)
+    {
+      if(_size != _capacity) {
+        const size_type slot = _slot(_size);
+        std::construct_at(&_buffer[slot], std::forward< Args >(args)...);
+        if(_size == 0) {
+          _index = slot;
+        }
+        _size ++;
+        _renumber();
+        return _buffer[slot];
+      }
+      const size_type slot = _index;
+      _buffer[slot] = value_type(std::forward< Args >(args)...);
+      _index = (_index + _capacity - 1) % _capacity;
+      _renumber();
+      return _buffer[slot];
     }
         
     constexpr void resize(size_type count)
@@ -507,32 +1135,18 @@ namespace anr
     
     constexpr void resize(size_type count, const_reference value)
     {
-      if(count == _size) {
+      if(count < _size) {
+        pop_back_n(_size - count);
         return;
       }
-      if(count < _size) {
-        auto beg = rbegin();
-        for(auto it = rbegin(); it != rend()-(_size-count); ++it) {
-          *it = *(beg + (_size - count));
-        }
-        _index = std::distance(&_buffer[0], &(*(rend()-(_size-count))));
-        _size = count;
+      if(count > _capacity) {
+        reserve(count);
       }
-      else {
-        if(count < _capacity) {
-          for(size_type i = 0; i < count; ++i) {
-            _construct(_index++, value);
-            _size ++;
-          }
-        }
-        else {
-          reserve(count);
-          for(size_type i = _index+1; i < _capacity; ++i) {
-            _construct(i, value);
-          }
-          _size = _capacity;
-          _index = _capacity-1;
-        }
+      while(_size < count) {
+        _index = (_index + 1) % _capacity;
+        _construct(_index, value);
+        _size ++;
+        _sequence ++;
       }
     }
     
@@ -544,6 +1158,7 @@ namespace anr
         std::swap(_index, other._index);
         std::swap(_capacity, other._capacity);
         std::swap(_size, other._size);
+        std::swap(_sequence, other._sequence);
       }
     }
 
@@ -568,7 +1183,7 @@ namespace anr
     
     constexpr size_type _index(size_type offset) const
     {
-      return (_parent._size - offset - 1) % _parent._capacity;
+      return _parent._slot(offset);
     }
     
     constexpr explicit circular_buffer_iterator(const circular_buffer< T, Allocator > &parent, size_type offset = 0) noexcept
@@ -579,8 +1194,17 @@ namespace anr
     
    public:
     friend circular_buffer< T, Allocator>;
+    template< class > friend class circular_buffer_iterator;
    
     constexpr circular_buffer_iterator(const circular_buffer_iterator& other) noexcept = default;
+    
+    // An iterator converts to a const_iterator.
+    template< class Other > requires (std::is_const_v< Type > && std::is_same_v< Other, value_type >)
+    constexpr circular_buffer_iterator(const circular_buffer_iterator< Other >& other) noexcept
+      : _offset(other._offset)
+      , _parent(other._parent)
+    {
+    }
     constexpr circular_buffer_iterator(circular_buffer_iterator&& other) noexcept = default;
     constexpr circular_buffer_iterator& operator=(const circular_buffer_iterator& other) noexcept = default;
     constexpr circular_buffer_iterator& operator=(circular_buffer_iterator&& other) noexcept = default;
@@ -681,6 +1305,34 @@ namespace anr
     
   };
 
+  // A position in the circular buffer identified by the absolute sequence number of the element,
+  // which remains meaningful after the element has been overwritten.
+  template< class T, class Allocator >
+  class circular_buffer< T, Allocator >::handle
+  {
+   private:
+    sequence_type _sequence;
+    
+   public:
+    constexpr handle() noexcept
+      : _sequence(std::numeric_limits< sequence_type >::max())
+    {
+    }
+    
+    constexpr explicit handle(sequence_type sequence) noexcept
+      : _sequence(sequence)
+    {
+    }
+    
+    constexpr sequence_type sequence() const noexcept
+    {
+      return _sequence;
+    }
+    
+    constexpr bool operator==(const handle& other) const noexcept = default;
+    
+  };
+
 }
 
 #endif // CIRCULAR_BUFFER
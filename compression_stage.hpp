@@ -0,0 +1,406 @@
+// Streaming compression stage between a circular buffer and a sink for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_COMPRESSION_STAGE
+#define CIRCULAR_BUFFER_COMPRESSION_STAGE
+
+#include "circular_buffer.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace anr
+{
+
+  // A fast LZ77 codec in the spirit of LZ4. A compressed block is a series of sequences made of a
+  // token (literal length in the high nibble, match length minus 4 in the low one, 15 meaning that
+  // 255-terminated extra bytes follow), the literals, then the 16-bit little-endian offset of the
+  // match and its extra length bytes. The last sequence only has literals.
+  namespace lz
+  {
+
+    inline constexpr std::size_t npos = std::numeric_limits< std::size_t >::max();
+
+    namespace detail
+    {
+
+      inline constexpr std::size_t min_match = 4;
+      inline constexpr std::size_t max_offset = 65535;
+      inline constexpr int hash_bits = 12;
+
+      inline std::uint32_t load32(const std::byte* p) noexcept
+      {
+        std::uint32_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+      }
+
+      inline std::uint64_t load64(const std::byte* p) noexcept
+      {
+        std::uint64_t value;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+      }
+
+      inline std::uint32_t hash(std::uint32_t sequence) noexcept
+      {
+        return (sequence * 2654435761u) >> (32 - hash_bits);
+      }
+
+      // Writes the extra bytes of a length of at least 15, returns false if they do not fit.
+      inline bool put_length(std::byte* dst, std::size_t& op, std::size_t capacity, std::size_t length) noexcept
+      {
+        for(length -= 15; ; length -= 255) {
+          if(op == capacity) {
+            return false;
+          }
+          dst[op++] = std::byte(length < 255 ? length : 255);
+          if(length < 255) {
+            return true;
+          }
+        }
+      }
+
+      inline bool get_length(const std::byte* src, std::size_t& ip, std::size_t size, std::size_t& length) noexcept
+      {
+        for(;;) {
+          if(ip == size) {
+            return false;
+          }
+          const std::size_t extra = std::to_integer< std::size_t >(src[ip++]);
+          length += extra;
+          if(extra != 255) {
+            return true;
+          }
+        }
+      }
+
+      inline bool put_sequence(std::byte* dst, std::size_t& op, std::size_t capacity, const std::byte* literals, std::size_t literal_length, std::size_t offset, std::size_t match_length) noexcept
+      {
+        if(op == capacity) {
+          return false;
+        }
+        const std::size_t match_code = match_length != 0 ? match_length - min_match : 0;
+        dst[op++] = std::byte((literal_length < 15 ? literal_length : 15) << 4 | (match_code < 15 ? match_code : 15));
+        if(literal_length >= 15 && !put_length(dst, op, capacity, literal_length)) {
+          return false;
+        }
+        if(capacity - op < literal_length) {
+          return false;
+        }
+        if(literal_length != 0) {
+          std::memcpy(dst + op, literals, literal_length);
+          op += literal_length;
+        }
+        if(match_length == 0) {
+          return true;
+        }
+        if(capacity - op < 2) {
+          return false;
+        }
+        dst[op++] = std::byte(offset & 0xff);
+        dst[op++] = std::byte(offset >> 8);
+        return match_code < 15 || put_length(dst, op, capacity, match_code);
+      }
+
+    }
+
+    // Size of the output buffer for which compress never fails.
+    constexpr std::size_t compress_bound(std::size_t size) noexcept
+    {
+      return size + size / 255 + 16;
+    }
+
+    // Compresses [src, src + size) into [dst, dst + capacity) and returns the compressed size,
+    // or 0 if it does not fit.
+    inline std::size_t compress(const std::byte* src, std::size_t size, std::byte* dst, std::size_t capacity) noexcept
+    {
+      std::uint32_t table[std::size_t(1) << detail::hash_bits] = {};
+      std::size_t ip = 0;
+      std::size_t anchor = 0;
+      std::size_t op = 0;
+      while(ip < size && size - ip >= detail::min_match) {
+        const std::uint32_t sequence = detail::load32(src + ip);
+        const std::uint32_t h = detail::hash(sequence);
+        const std::size_t candidate = table[h];
+        table[h] = static_cast< std::uint32_t >(ip);
+        if(candidate < ip && ip - candidate <= detail::max_offset && detail::load32(src + candidate) == sequence) {
+          std::size_t length = detail::min_match;
+          // The match is extended 8 bytes at a time, the first differing byte being found with a bit scan.
+          while(size - ip - length >= 8) {
+            const std::uint64_t diff = detail::load64(src + candidate + length) ^ detail::load64(src + ip + length);
+            if(diff != 0) {
+              length += (std::endian::native == std::endian::little ? std::countr_zero(diff) : std::countl_zero(diff)) / 8;
+              break;
+            }
+            length += 8;
+          }
+          if(size - ip - length < 8) {
+            while(ip + length < size && src[candidate + length] == src[ip + length]) {
+              length ++;
+            }
+          }
+          if(!detail::put_sequence(dst, op, capacity, src + anchor, ip - anchor, ip - candidate, length)) {
+            return 0;
+          }
+          ip += length;
+          anchor = ip;
+        }
+        else {
+          // The longer the literal run, the faster the incompressible data is skipped.
+          ip += 1 + ((ip - anchor) >> 6);
+        }
+      }
+      return detail::put_sequence(dst, op, capacity, src + anchor, size - anchor, 0, 0) ? op : 0;
+    }
+
+    // Decompresses [src, src + size) into [dst, dst + capacity) and returns the decompressed
+    // size, or npos if the input is corrupted or does not fit.
+    inline std::size_t decompress(const std::byte* src, std::size_t size, std::byte* dst, std::size_t capacity) noexcept
+    {
+      std::size_t ip = 0;
+      std::size_t op = 0;
+      while(ip < size) {
+        const std::size_t token = std::to_integer< std::size_t >(src[ip++]);
+        std::size_t literal_length = token >> 4;
+        if(literal_length == 15 && !detail::get_length(src, ip, size, literal_length)) {
+          return npos;
+        }
+        if(size - ip < literal_length || capacity - op < literal_length) {
+          return npos;
+        }
+        if(literal_length != 0) {
+          std::memcpy(dst + op, src + ip, literal_length);
+        }
+        ip += literal_length;
+        op += literal_length;
+        if(ip == size) {
+          break;
+        }
+
+        if(size - ip < 2) {
+          return npos;
+        }
+        const std::size_t offset = std::to_integer< std::size_t >(src[ip]) | std::to_integer< std::size_t >(src[ip + 1]) << 8;
+        ip += 2;
+        std::size_t match_length = token & 15;
+        if(match_length == 15 && !detail::get_length(src, ip, size, match_length)) {
+          return npos;
+        }
+        match_length += detail::min_match;
+        if(offset == 0 || offset > op || capacity - op < match_length) {
+          return npos;
+        }
+        if(offset >= match_length) {
+          std::memcpy(dst + op, dst + op - offset, match_length);
+          op += match_length;
+        }
+        else {
+          // The match overlaps the bytes it produces.
+          for(std::size_t i = 0; i < match_length; ++i, ++op) {
+            dst[op] = dst[op - offset];
+          }
+        }
+      }
+      return op;
+    }
+
+  }
+
+  struct compressed_block
+  {
+    bool compressed;
+    std::size_t original_size;
+    std::span< const std::byte > data;
+  };
+
+  // The producer writes into a circular buffer protected by a mutex, and a worker thread takes
+  // its bytes a full block at a time, compresses them outside of the lock and hands them to the
+  // sink. A block that does not shrink is handed uncompressed.
+  template< class Allocator = std::allocator< std::byte > >
+  class compression_stage
+  {
+   public:
+    typedef Allocator                                         allocator_type;
+    typedef std::size_t                                       size_type;
+    typedef std::function< void(const compressed_block&) >    sink_type;
+
+
+   private:
+    circular_buffer< std::byte, Allocator > _ring;
+    size_type _block_size;
+    bool _compress;
+    sink_type _sink;
+    std::vector< std::byte > _input;
+    std::vector< std::byte > _output;
+    std::mutex _mutex;
+    std::condition_variable _not_full;
+    std::condition_variable _ready;
+    std::condition_variable _idle;
+    bool _flushing;
+    bool _stopping;
+    bool _busy;
+    std::atomic< std::uint64_t > _input_bytes;
+    std::atomic< std::uint64_t > _output_bytes;
+    std::thread _worker;
+
+    void _emit(size_type size)
+    {
+      const size_type compressed = _compress ? lz::compress(_input.data(), size, _output.data(), size - 1) : 0;
+      const compressed_block block = compressed != 0
+        ? compressed_block{true, size, std::span< const std::byte >(_output.data(), compressed)}
+        : compressed_block{false, size, std::span< const std::byte >(_input.data(), size)};
+      _input_bytes += size;
+      _output_bytes += block.data.size();
+      _sink(block);
+    }
+
+    void _run()
+    {
+      std::unique_lock< std::mutex > lock(_mutex);
+      for(;;) {
+        _ready.wait(lock, [this] {
+          return _ring.size() >= _block_size || ((_flushing || _stopping) && !_ring.empty()) || _stopping;
+        });
+        if(_ring.empty()) {
+          return;
+        }
+        const size_type size = _ring.pop_back_n(_input.data(), _block_size);
+        _busy = true;
+        _not_full.notify_all();
+        lock.unlock();
+        _emit(size);
+        lock.lock();
+        _busy = false;
+        if(_ring.empty()) {
+          _idle.notify_all();
+        }
+      }
+    }
+
+
+   public:
+    compression_stage(size_type capacity, size_type block_size, sink_type sink, bool compress = true, const Allocator& alloc = Allocator())
+      : _ring(alloc)
+      , _block_size(block_size)
+      , _compress(compress)
+      , _sink(std::move(sink))
+      , _input(block_size)
+      , _output(block_size)
+      , _mutex()
+      , _not_full()
+      , _ready()
+      , _idle()
+      , _flushing(false)
+      , _stopping(false)
+      , _busy(false)
+      , _input_bytes(0)
+      , _output_bytes(0)
+      , _worker()
+    {
+      assert(( block_size != 0 && capacity >= block_size ));
+      _ring.reserve(capacity);
+      _worker = std::thread(&compression_stage::_run, this);
+    }
+
+    compression_stage(const compression_stage&) = delete;
+    compression_stage& operator=(const compression_stage&) = delete;
+
+    // Hands the remaining bytes to the sink and stops the worker.
+    ~compression_stage()
+    {
+      {
+        std::lock_guard< std::mutex > lock(_mutex);
+        _stopping = true;
+      }
+      _ready.notify_one();
+      _worker.join();
+    }
+
+    size_type block_size() const noexcept
+    {
+      return _block_size;
+    }
+
+    std::uint64_t input_bytes() const noexcept
+    {
+      return _input_bytes.load(std::memory_order_relaxed);
+    }
+
+    std::uint64_t output_bytes() const noexcept
+    {
+      return _output_bytes.load(std::memory_order_relaxed);
+    }
+
+    // Appends the bytes to the stage, waiting for room while the buffer is full.
+    void write(const std::byte* data, size_type size)
+    {
+      std::unique_lock< std::mutex > lock(_mutex);
+      while(size != 0) {
+        _not_full.wait(lock, [this] {
+          return _ring.size() != _ring.capacity();
+        });
+        const size_type count = std::min(size, _ring.capacity() - _ring.size());
+        _ring.push_back_n(data, count);
+        data += count;
+        size -= count;
+        if(_ring.size() >= _block_size) {
+          _ready.notify_one();
+        }
+      }
+    }
+
+    void write(std::span< const std::byte > data)
+    {
+      write(data.data(), data.size());
+    }
+
+    // Hands the bytes written so far to the sink, the last block being partial, and waits for it.
+    void flush()
+    {
+      std::unique_lock< std::mutex > lock(_mutex);
+      _flushing = true;
+      _ready.notify_one();
+      _idle.wait(lock, [this] {
+        return _ring.empty() && !_busy;
+      });
+      _flushing = false;
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_COMPRESSION_STAGE
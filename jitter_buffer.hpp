@@ -0,0 +1,276 @@
+// Adaptive jitter buffer for media streams for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_JITTER_BUFFER
+#define CIRCULAR_BUFFER_JITTER_BUFFER
+
+#include "circular_buffer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <optional>
+#include <utility>
+
+namespace anr
+{
+
+  enum class playout_status
+  {
+    buffering,
+    played,
+    concealed,
+    stretched
+  };
+
+  // The slots of the circular buffer hold the frames from the next one to play (the oldest slot)
+  // to the newest one received, a slot per frame period of the media timestamps. The jitter is
+  // estimated as in RFC 3550 and the target delay follows it, the buffer converging to it by
+  // inserting a concealment period or dropping a frame at most once per playout period.
+  template< class T, class Clock = std::chrono::steady_clock, class Allocator = std::allocator< std::optional< T > > >
+  class jitter_buffer
+  {
+   public:
+    typedef T                             value_type;
+    typedef Allocator                     allocator_type;
+    typedef std::size_t                   size_type;
+    typedef std::uint64_t                 timestamp_type;
+    typedef std::uint64_t                 index_type;
+    typedef typename Clock::time_point    time_point;
+    typedef typename Clock::duration      duration;
+
+
+   private:
+    circular_buffer< std::optional< T >, Allocator > _ring;
+    timestamp_type _ticks_per_frame;
+    duration _frame_duration;
+    duration _min_delay;
+    duration _max_delay;
+    double _jitter;
+    duration _last_transit;
+    index_type _next;
+    bool _started;
+    bool _playing;
+    size_type _late;
+    size_type _dropped;
+
+    void _estimate(index_type index, time_point now) noexcept
+    {
+      const duration transit = now.time_since_epoch() - static_cast< typename duration::rep >(index) * _frame_duration;
+      if(_started) {
+        const double d = std::abs(static_cast< double >((transit - _last_transit).count()));
+        _jitter += (d - _jitter) / 16;
+      }
+      _last_transit = transit;
+    }
+
+    // Removes the oldest slot and returns its frame, if any.
+    std::optional< T > _advance()
+    {
+      _next ++;
+      if(_ring.empty()) {
+        return std::nullopt;
+      }
+      std::optional< T > frame = std::move(_ring.back());
+      _ring.pop_back();
+      return frame;
+    }
+
+    // Drops the oldest slot, counting it if it held a frame.
+    void _drop()
+    {
+      if(_advance()) {
+        _dropped ++;
+      }
+    }
+
+    template< class... Args >
+    bool _push(timestamp_type timestamp, time_point now, Args&&... args)
+    {
+      const index_type index = timestamp / _ticks_per_frame;
+      _estimate(index, now);
+      if(!_started) {
+        _next = index;
+        _started = true;
+      }
+      if(index < _next) {
+        _late ++;
+        return false;
+      }
+      if(index - _next >= 2 * _ring.capacity()) {
+        _ring.for_each([this](const std::optional< T >& slot) {
+          _dropped += slot.has_value();
+        });
+        _ring.clear();
+        _next = index + 1 - _ring.capacity();
+      }
+      while(index - _next >= _ring.capacity()) {
+        _drop();
+      }
+      while(_next + _ring.size() <= index) {
+        _ring.push_back(std::nullopt);
+      }
+      std::optional< T >& slot = _ring[_next + _ring.size() - 1 - index];
+      if(slot) {
+        return false;
+      }
+      slot.emplace(std::forward< Args >(args)...);
+      return true;
+    }
+
+
+   public:
+    jitter_buffer(size_type capacity, timestamp_type ticks_per_frame, duration frame_duration, duration min_delay, duration max_delay, const Allocator& alloc = Allocator())
+      : _ring(alloc)
+      , _ticks_per_frame(ticks_per_frame)
+      , _frame_duration(frame_duration)
+      , _min_delay(min_delay)
+      , _max_delay(max_delay)
+      , _jitter(0)
+      , _last_transit()
+      , _next(0)
+      , _started(false)
+      , _playing(false)
+      , _late(0)
+      , _dropped(0)
+    {
+      assert(( capacity != 0 && ticks_per_frame != 0 && frame_duration.count() > 0 ));
+      _ring.reserve(capacity);
+    }
+
+    // Delays
+
+    duration jitter() const noexcept
+    {
+      return duration(static_cast< typename duration::rep >(_jitter));
+    }
+
+    // Delay the buffer converges to: the minimum delay plus four times the jitter, up to the maximum delay.
+    duration target_delay() const noexcept
+    {
+      const duration delay = _min_delay + 4 * jitter();
+      return delay < _max_delay ? delay : _max_delay;
+    }
+
+    // Delay of the newest frame received relative to the next frame to play.
+    duration delay() const noexcept
+    {
+      return static_cast< typename duration::rep >(_ring.size()) * _frame_duration;
+    }
+
+    // Capacity
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _ring.empty();
+    }
+
+    size_type capacity() const noexcept
+    {
+      return _ring.capacity();
+    }
+
+    index_type next_index() const noexcept
+    {
+      return _next;
+    }
+
+    // Number of frames received after their playout.
+    size_type late() const noexcept
+    {
+      return _late;
+    }
+
+    // Number of frames dropped to reduce the delay or because they did not fit in the buffer.
+    size_type dropped() const noexcept
+    {
+      return _dropped;
+    }
+
+    // Modifiers
+
+    // Stores a frame received at now. Returns false and does nothing if the frame is late or
+    // was already received. A frame beyond the capacity drops the oldest ones.
+    bool push(timestamp_type timestamp, const T& frame, time_point now)
+    {
+      return _push(timestamp, now, frame);
+    }
+
+    bool push(timestamp_type timestamp, T&& frame, time_point now)
+    {
+      return _push(timestamp, now, std::move(frame));
+    }
+
+    // To be called once per frame period. Calls play(index, frame) with the next frame, or
+    // conceal(index) if it is missing or if the buffer stretches the delay, index being the
+    // index of the next frame to play. Nothing is called until the buffer first reaches the
+    // target delay.
+    template< class Play, class Conceal >
+    playout_status pop(Play&& play, Conceal&& conceal)
+    {
+      const duration target = target_delay();
+      const size_type frames = std::max< size_type >(1, static_cast< size_type >((target + _frame_duration - duration(1)) / _frame_duration));
+      if(!_playing) {
+        if(_ring.size() < frames) {
+          return playout_status::buffering;
+        }
+        _playing = true;
+      }
+
+      if(_ring.size() + 1 < frames) {
+        conceal(_next);
+        return playout_status::stretched;
+      }
+      if(_ring.size() > frames + 1) {
+        _drop();
+      }
+
+      const index_type index = _next;
+      std::optional< T > frame = _advance();
+      if(!frame) {
+        conceal(index);
+        return playout_status::concealed;
+      }
+      play(index, std::move(*frame));
+      return playout_status::played;
+    }
+
+    // Drops the frames and the jitter estimate, the next frame received starting a new stream.
+    void reset() noexcept
+    {
+      _ring.clear();
+      _jitter = 0;
+      _started = false;
+      _playing = false;
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_JITTER_BUFFER
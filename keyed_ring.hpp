@@ -0,0 +1,227 @@
+// Circular buffer indexed by key for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_KEYED_RING
+#define CIRCULAR_BUFFER_KEYED_RING
+
+#include "circular_buffer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace anr
+{
+
+  // The index is an open-addressing hash table of sequence numbers, with linear probing and
+  // backward shift deletion. It only stores the sequence numbers, the keys being read from the
+  // ring, and is at most half full so that the probe sequences stay short.
+  template< class Key, class T, class Hash = std::hash< Key >, class KeyEqual = std::equal_to< Key >, class Allocator = std::allocator< std::pair< Key, T > > >
+  class keyed_ring
+  {
+   public:
+    typedef Key                 key_type;
+    typedef T                   mapped_type;
+    typedef std::pair< Key, T > value_type;
+    typedef Allocator           allocator_type;
+    typedef std::size_t         size_type;
+
+
+   private:
+    typedef circular_buffer< value_type, Allocator >  ring_type;
+    typedef typename ring_type::sequence_type         sequence_type;
+    typedef typename ring_type::handle                handle;
+
+    static constexpr sequence_type empty_slot = std::numeric_limits< sequence_type >::max();
+
+    ring_type _ring;
+    std::vector< sequence_type > _table;
+    size_type _mask;
+    [[no_unique_address]] Hash _hash;
+    [[no_unique_address]] KeyEqual _equal;
+
+    const Key& _key(sequence_type seq) const noexcept
+    {
+      return _ring[handle(seq)].first;
+    }
+
+    size_type _home(const Key& key) const
+    {
+      return _hash(key) & _mask;
+    }
+
+    // Returns the slot holding key, or the empty slot ending its probe sequence.
+    size_type _probe(const Key& key) const
+    {
+      size_type slot = _home(key);
+      while(_table[slot] != empty_slot && !_equal(_key(_table[slot]), key)) {
+        slot = (slot + 1) & _mask;
+      }
+      return slot;
+    }
+
+    void _unindex(size_type slot)
+    {
+      // Moves back the following entries of the cluster that the hole separates from their home slot.
+      for(size_type next = (slot + 1) & _mask; _table[next] != empty_slot; next = (next + 1) & _mask) {
+        const size_type home = _home(_key(_table[next]));
+        if(((next - home) & _mask) >= ((next - slot) & _mask)) {
+          _table[slot] = _table[next];
+          slot = next;
+        }
+      }
+      _table[slot] = empty_slot;
+    }
+
+
+   public:
+    explicit keyed_ring(size_type capacity, const Hash& hash = Hash(), const KeyEqual& equal = KeyEqual(), const Allocator& alloc = Allocator())
+      : _ring(alloc)
+      , _table(std::bit_ceil(2 * (capacity != 0 ? capacity : 1)), empty_slot)
+      , _mask(_table.size() - 1)
+      , _hash(hash)
+      , _equal(equal)
+    {
+      _ring.reserve(capacity != 0 ? capacity : 1);
+    }
+
+    // Element access
+
+    T* find_by_key(const Key& key)
+    {
+      const sequence_type seq = _table[_probe(key)];
+      return seq != empty_slot ? &_ring[handle(seq)].second : nullptr;
+    }
+
+    const T* find_by_key(const Key& key) const
+    {
+      const sequence_type seq = _table[_probe(key)];
+      return seq != empty_slot ? &_ring[handle(seq)].second : nullptr;
+    }
+
+    bool contains(const Key& key) const
+    {
+      return _table[_probe(key)] != empty_slot;
+    }
+
+    value_type& front() noexcept
+    {
+      return _ring.front();
+    }
+
+    const value_type& front() const noexcept
+    {
+      return _ring.front();
+    }
+
+    value_type& back() noexcept
+    {
+      return _ring.back();
+    }
+
+    const value_type& back() const noexcept
+    {
+      return _ring.back();
+    }
+
+    // Calls function(key, value) from the oldest element to the newest.
+    template< class Function >
+    void for_each(Function&& function)
+    {
+      _ring.for_each([&](value_type& element) {
+        function(std::as_const(element.first), element.second);
+      });
+    }
+
+    // Capacity
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _ring.empty();
+    }
+
+    size_type size() const noexcept
+    {
+      return _ring.size();
+    }
+
+    size_type capacity() const noexcept
+    {
+      return _ring.capacity();
+    }
+
+    // Modifiers
+
+    // Inserts value as the newest element, evicting the oldest one if the ring is full.
+    // Returns false and does nothing if key is already in the ring.
+    bool push(const Key& key, const T& value)
+    {
+      return emplace(key, value);
+    }
+
+    bool push(const Key& key, T&& value)
+    {
+      return emplace(key, std::move(value));
+    }
+
+    template< class... Args >
+    bool emplace(const Key& key, Args&&... args)
+    {
+      if(_table[_probe(key)] != empty_slot) {
+        return false;
+      }
+      if(_ring.size() == _ring.capacity()) {
+        pop_back();
+      }
+      _ring.emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward< Args >(args)...));
+      _table[_probe(key)] = _ring.handle_at(0).sequence();
+      return true;
+    }
+
+    // Removes the oldest element.
+    void pop_back()
+    {
+      assert(( !_ring.empty() ));
+      _unindex(_probe(_ring.back().first));
+      _ring.pop_back();
+    }
+
+    void clear() noexcept
+    {
+      _ring.clear();
+      std::fill(_table.begin(), _table.end(), empty_slot);
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_KEYED_RING
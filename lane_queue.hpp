@@ -0,0 +1,201 @@
+// Multi-lane priority queue of circular buffers for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_LANE_QUEUE
+#define CIRCULAR_BUFFER_LANE_QUEUE
+
+#include "circular_buffer.hpp"
+
+#include <array>
+#include <bit>
+
+namespace anr
+{
+
+  // Lane 0 has the highest priority. A bitmap of the non-empty lanes makes both the
+  // strict priority and the weighted round-robin dequeues O(1).
+  template< class T, std::size_t Lanes, class Allocator = std::allocator< T > >
+  class lane_queue
+  {
+    static_assert(Lanes != 0 && Lanes <= 64, "A lane_queue has between 1 and 64 lanes");
+
+   public:
+    typedef T             value_type;
+    typedef Allocator     allocator_type;
+    typedef std::size_t   size_type;
+
+
+   private:
+    std::array< circular_buffer< T, Allocator >, Lanes > _lanes;
+    std::array< overrun_policy, Lanes > _policies;
+    std::array< size_type, Lanes > _weights;
+    std::uint64_t _nonempty;
+    size_type _current;
+    size_type _credit;
+
+    template< class Value >
+    bool _push(size_type lane, Value&& value)
+    {
+      assert(( lane < Lanes ));
+      circular_buffer< T, Allocator >& buffer = _lanes[lane];
+      if(buffer.size() == buffer.capacity() && _policies[lane] == overrun_policy::block) {
+        return false;
+      }
+      buffer.push_back(std::forward< Value >(value));
+      _nonempty |= std::uint64_t(1) << lane;
+      return true;
+    }
+
+    void _pop(size_type lane, T& out)
+    {
+      circular_buffer< T, Allocator >& buffer = _lanes[lane];
+      out = std::move(buffer.back());
+      buffer.pop_back();
+      if(buffer.empty()) {
+        _nonempty &= ~(std::uint64_t(1) << lane);
+      }
+    }
+
+    // First non-empty lane after the current one, wrapping around.
+    size_type _next_lane() const noexcept
+    {
+      const std::uint64_t after = _current + 1 < 64 ? _nonempty & (~std::uint64_t(0) << (_current + 1)) : 0;
+      return std::countr_zero(after != 0 ? after : _nonempty);
+    }
+
+
+   public:
+    explicit lane_queue(size_type capacity, overrun_policy policy = overrun_policy::overwrite, const Allocator& alloc = Allocator())
+      : _lanes()
+      , _policies()
+      , _weights()
+      , _nonempty(0)
+      , _current(Lanes-1)
+      , _credit(0)
+    {
+      for(size_type lane = 0; lane < Lanes; ++lane) {
+        _lanes[lane] = circular_buffer< T, Allocator >(alloc);
+        _lanes[lane].reserve(capacity);
+        _policies[lane] = policy;
+        _weights[lane] = 1;
+      }
+    }
+
+    void configure(size_type lane, size_type capacity, overrun_policy policy)
+    {
+      assert(( lane < Lanes ));
+      _lanes[lane].reserve(capacity);
+      _policies[lane] = policy;
+      if(_lanes[lane].empty()) {
+        _nonempty &= ~(std::uint64_t(1) << lane);
+      }
+    }
+
+    void set_weight(size_type lane, size_type weight) noexcept
+    {
+      assert(( lane < Lanes && weight != 0 ));
+      _weights[lane] = weight;
+    }
+
+    // Capacity
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _nonempty == 0;
+    }
+
+    size_type size() const noexcept
+    {
+      size_type total = 0;
+      for(const auto& lane : _lanes) {
+        total += lane.size();
+      }
+      return total;
+    }
+
+    size_type size(size_type lane) const noexcept
+    {
+      return _lanes[lane].size();
+    }
+
+    size_type capacity(size_type lane) const noexcept
+    {
+      return _lanes[lane].capacity();
+    }
+
+    // Modifiers
+
+    bool push(size_type lane, const T& value)
+    {
+      return _push(lane, value);
+    }
+
+    bool push(size_type lane, T&& value)
+    {
+      return _push(lane, std::move(value));
+    }
+
+    // Dequeues the oldest element of the highest priority non-empty lane.
+    bool pop(T& out)
+    {
+      if(_nonempty == 0) {
+        return false;
+      }
+      _pop(std::countr_zero(_nonempty), out);
+      return true;
+    }
+
+    // Dequeues up to weight(lane) consecutive elements from each non-empty lane in turn.
+    bool pop_weighted(T& out)
+    {
+      if(_nonempty == 0) {
+        return false;
+      }
+      if(_credit == 0 || (_nonempty & (std::uint64_t(1) << _current)) == 0) {
+        _current = _next_lane();
+        _credit = _weights[_current];
+      }
+      _pop(_current, out);
+      _credit --;
+      return true;
+    }
+
+    void clear() noexcept
+    {
+      for(auto& lane : _lanes) {
+        lane.clear();
+      }
+      _nonempty = 0;
+      _credit = 0;
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_LANE_QUEUE
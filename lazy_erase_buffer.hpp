@@ -0,0 +1,203 @@
+// Circular buffer with O(1) lazy erase through tombstones for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_LAZY_ERASE_BUFFER
+#define CIRCULAR_BUFFER_LAZY_ERASE_BUFFER
+
+#include "circular_buffer.hpp"
+#include "occupancy_bitmap.hpp"
+
+namespace anr
+{
+
+  // Erased elements stay in the circular buffer as tombstones, i.e. elements whose bit is
+  // cleared in a bitmap of the live elements indexed by sequence number. The iteration and
+  // the pops skip them with bit scans, and they are reclaimed once they reach the oldest end.
+  template< class T, class Allocator = std::allocator< T > >
+  class lazy_erase_buffer
+  {
+   public:
+    typedef T                                                 value_type;
+    typedef Allocator                                         allocator_type;
+    typedef std::size_t                                       size_type;
+    typedef typename circular_buffer< T, Allocator >::handle  handle;
+
+
+   private:
+    circular_buffer< T, Allocator > _buffer;
+    occupancy_bitmap _live;
+    size_type _live_count;
+    size_type _compaction_step;
+
+    occupancy_bitmap::sequence_type _oldest() const noexcept
+    {
+      return _buffer.next_sequence() - _buffer.size();
+    }
+
+    // Reclaims at most count tombstones at the oldest end.
+    void _trim(size_type count)
+    {
+      for(size_type i = 0; i < count && !_buffer.empty() && !_live.test(_oldest()); ++i) {
+        _buffer.pop_back();
+      }
+    }
+
+    void _make_room()
+    {
+      _trim(_compaction_step);
+      if(_buffer.size() == _buffer.capacity() && _live.test(_oldest())) {
+        _live.reset(_oldest());
+        _live_count --;
+      }
+    }
+
+    handle _pushed()
+    {
+      const handle h = _buffer.handle_at(0);
+      _live.set(h.sequence());
+      _live_count ++;
+      return h;
+    }
+
+
+   public:
+    explicit lazy_erase_buffer(size_type capacity, size_type compaction_step = 2, const Allocator& alloc = Allocator())
+      : _buffer(alloc)
+      , _live(capacity)
+      , _live_count(0)
+      , _compaction_step(compaction_step)
+    {
+      assert(( capacity != 0 ));
+      _buffer.reserve(capacity);
+    }
+
+    // Element access
+
+    bool contains(handle h) const noexcept
+    {
+      return _buffer.is_valid(h) && _live.test(h.sequence());
+    }
+
+    T& operator[](handle h) noexcept
+    {
+      assert(( contains(h) ));
+      return _buffer[h];
+    }
+
+    const T& operator[](handle h) const noexcept
+    {
+      assert(( contains(h) ));
+      return _buffer[h];
+    }
+
+    // Calls function(element) for the live elements, from the oldest to the newest.
+    template< class Function >
+    void for_each(Function&& function)
+    {
+      const auto last = _buffer.next_sequence();
+      for(auto seq = _live.find_set(_oldest(), last); seq != occupancy_bitmap::npos; seq = _live.find_set(seq + 1, last)) {
+        function(_buffer[handle(seq)]);
+      }
+    }
+
+    // Capacity
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _live_count == 0;
+    }
+
+    size_type size() const noexcept
+    {
+      return _live_count;
+    }
+
+    size_type tombstones() const noexcept
+    {
+      return _buffer.size() - _live_count;
+    }
+
+    size_type capacity() const noexcept
+    {
+      return _buffer.capacity();
+    }
+
+    // Modifiers
+
+    handle push(const T& value)
+    {
+      _make_room();
+      _buffer.push_back(value);
+      return _pushed();
+    }
+
+    handle push(T&& value)
+    {
+      _make_room();
+      _buffer.push_back(std::move(value));
+      return _pushed();
+    }
+
+    bool erase(handle h) noexcept
+    {
+      if(!contains(h)) {
+        return false;
+      }
+      _live.reset(h.sequence());
+      _live_count --;
+      return true;
+    }
+
+    // Moves the oldest live element to out.
+    bool pop(T& out)
+    {
+      const auto seq = _live.find_set(_oldest(), _buffer.next_sequence());
+      if(seq == occupancy_bitmap::npos) {
+        _trim(_buffer.size());
+        return false;
+      }
+      _trim(seq - _oldest());
+      out = std::move(_buffer.back());
+      _live.reset(seq);
+      _live_count --;
+      _buffer.pop_back();
+      return true;
+    }
+
+    void clear() noexcept
+    {
+      _buffer.clear();
+      _live.clear();
+      _live_count = 0;
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_LAZY_ERASE_BUFFER
@@ -0,0 +1,159 @@
+// Allocator based on anonymous memory mappings for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_MMAP_ALLOCATOR
+#define CIRCULAR_BUFFER_MMAP_ALLOCATOR
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace anr
+{
+
+  // Reserves address space for the whole capacity with an anonymous mapping: pages are
+  // only committed when first written. Optionally, the pages entirely consumed by a
+  // circular buffer are given back to the system with madvise(MADV_DONTNEED).
+  template< class T >
+  class mmap_allocator
+  {
+   public:
+    typedef T             value_type;
+    typedef std::size_t   size_type;
+    typedef std::ptrdiff_t difference_type;
+
+    template< class U >
+    struct rebind
+    {
+      typedef mmap_allocator< U > other;
+    };
+
+
+   private:
+    bool _release_consumed;
+
+    static std::uintptr_t _page_size() noexcept
+    {
+      static const std::uintptr_t page = static_cast< std::uintptr_t >(::sysconf(_SC_PAGESIZE));
+      return page;
+    }
+
+    static size_type _bytes(size_type n) noexcept
+    {
+      const std::uintptr_t page = _page_size();
+      return (n * sizeof(T) + page - 1) & ~(page - 1);
+    }
+
+
+   public:
+    constexpr explicit mmap_allocator(bool release_consumed = false) noexcept
+      : _release_consumed(release_consumed)
+    {
+    }
+
+    template< class U >
+    constexpr mmap_allocator(const mmap_allocator< U >& other) noexcept
+      : _release_consumed(other.release_consumed())
+    {
+    }
+
+    constexpr bool release_consumed() const noexcept
+    {
+      return _release_consumed;
+    }
+
+    T* allocate(size_type n)
+    {
+      if(n == 0) {
+        return nullptr;
+      }
+      void* p = ::mmap(nullptr, _bytes(n), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+      if(p == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+      return static_cast< T* >(p);
+    }
+
+    void deallocate(T* p, size_type n) noexcept
+    {
+      if(p != nullptr) {
+        ::munmap(p, _bytes(n));
+      }
+    }
+
+    T* reallocate(T* p, size_type old_n, size_type new_n)
+    {
+      if(p == nullptr) {
+        return allocate(new_n);
+      }
+#ifdef MREMAP_MAYMOVE
+      void* q = ::mremap(p, _bytes(old_n), _bytes(new_n), MREMAP_MAYMOVE);
+      if(q == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+      return static_cast< T* >(q);
+#else
+      T* q = allocate(new_n);
+      std::memcpy(q, p, (old_n < new_n ? old_n : new_n) * sizeof(T));
+      deallocate(p, old_n);
+      return q;
+#endif
+    }
+
+    // [first, last) is free and [consumed, last) has just been consumed: only the pages
+    // completed by the consumed elements are released.
+    void discard(T* first, T* consumed, T* last) noexcept
+    {
+      if(!_release_consumed) {
+        return;
+      }
+      const std::uintptr_t mask = ~(_page_size() - 1);
+      const std::uintptr_t lower = (reinterpret_cast< std::uintptr_t >(first) + _page_size() - 1) & mask;
+      const std::uintptr_t begin = reinterpret_cast< std::uintptr_t >(consumed) & mask;
+      const std::uintptr_t end = reinterpret_cast< std::uintptr_t >(last) & mask;
+      const std::uintptr_t from = begin > lower ? begin : lower;
+      if(from < end) {
+        ::madvise(reinterpret_cast< void* >(from), end - from, MADV_DONTNEED);
+      }
+    }
+
+    template< class U >
+    constexpr bool operator==(const mmap_allocator< U >&) const noexcept
+    {
+      return true;
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_MMAP_ALLOCATOR
@@ -0,0 +1,148 @@
+// Bitmap of occupied slots addressed modulo its size for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_OCCUPANCY_BITMAP
+#define CIRCULAR_BUFFER_OCCUPANCY_BITMAP
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace anr
+{
+
+  // One bit per slot, the slot of a sequence number being the sequence number modulo the size.
+  // The scans look for set bits a word at a time, wrapping around the end of the bitmap.
+  class occupancy_bitmap
+  {
+   public:
+    typedef std::size_t   size_type;
+    typedef std::uint64_t sequence_type;
+
+    static constexpr sequence_type npos = std::numeric_limits< sequence_type >::max();
+
+
+   private:
+    std::vector< std::uint64_t > _words;
+    size_type _size;
+
+    size_type _slot(sequence_type seq) const noexcept
+    {
+      return static_cast< size_type >(seq % _size);
+    }
+
+
+   public:
+    explicit occupancy_bitmap(size_type size = 0)
+      : _words((size + 63) / 64, 0)
+      , _size(size)
+    {
+    }
+
+    size_type size() const noexcept
+    {
+      return _size;
+    }
+
+    bool test(sequence_type seq) const noexcept
+    {
+      const size_type slot = _slot(seq);
+      return (_words[slot / 64] >> (slot % 64)) & 1;
+    }
+
+    void set(sequence_type seq) noexcept
+    {
+      const size_type slot = _slot(seq);
+      _words[slot / 64] |= std::uint64_t(1) << (slot % 64);
+    }
+
+    void reset(sequence_type seq) noexcept
+    {
+      const size_type slot = _slot(seq);
+      _words[slot / 64] &= ~(std::uint64_t(1) << (slot % 64));
+    }
+
+    void clear() noexcept
+    {
+      for(auto& word : _words) {
+        word = 0;
+      }
+    }
+
+    // Returns the first sequence number in [first, last) whose bit is set, or npos.
+    // last - first must not exceed size().
+    sequence_type find_set(sequence_type first, sequence_type last) const noexcept
+    {
+      assert(( last - first <= _size ));
+      while(first < last) {
+        const size_type slot = _slot(first);
+        const size_type bit = slot % 64;
+        // Bits of the current word from the slot to the end of the word, or of the bitmap.
+        const size_type span = std::min< size_type >(64 - bit, _size - slot);
+        std::uint64_t word = _words[slot / 64] >> bit;
+        if(span < 64) {
+          word &= (std::uint64_t(1) << span) - 1;
+        }
+        if(word != 0) {
+          const sequence_type found = first + std::countr_zero(word);
+          return found < last ? found : npos;
+        }
+        first += span;
+      }
+      return npos;
+    }
+
+    // Returns the first sequence number in [first, last) whose bit is not set, or npos.
+    sequence_type find_unset(sequence_type first, sequence_type last) const noexcept
+    {
+      assert(( last - first <= _size ));
+      while(first < last) {
+        const size_type slot = _slot(first);
+        const size_type bit = slot % 64;
+        const size_type span = std::min< size_type >(64 - bit, _size - slot);
+        std::uint64_t word = ~_words[slot / 64] >> bit;
+        if(span < 64) {
+          word &= (std::uint64_t(1) << span) - 1;
+        }
+        if(word != 0) {
+          const sequence_type found = first + std::countr_zero(word);
+          return found < last ? found : npos;
+        }
+        first += span;
+      }
+      return npos;
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_OCCUPANCY_BITMAP
@@ -0,0 +1,195 @@
+// Object pool recycling the objects published through a circular buffer for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_POOL_RING
+#define CIRCULAR_BUFFER_POOL_RING
+
+#include "circular_buffer.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+namespace anr
+{
+
+  template< class T, class Allocator = std::allocator< T > >
+  class pool_ring
+  {
+   public:
+    typedef T             value_type;
+    typedef Allocator     allocator_type;
+    typedef std::size_t   size_type;
+    typedef T*            pointer;
+
+
+   private:
+    typedef std::uint32_t index_type;
+    typedef typename std::allocator_traits< Allocator >::template rebind_alloc< pointer > pointer_allocator;
+    typedef typename std::allocator_traits< Allocator >::template rebind_alloc< std::atomic< index_type > > link_allocator;
+
+    static constexpr index_type nil = std::numeric_limits< index_type >::max();
+
+    allocator_type _allocator;
+    link_allocator _link_allocator;
+    size_type _pool_size;
+    pointer _objects;
+    std::atomic< index_type >* _next;
+    // Head of the free list: index of the first free object in the low half and
+    // a tag incremented on every update in the high half to avoid the ABA problem.
+    std::atomic< std::uint64_t > _free;
+    circular_buffer< pointer, pointer_allocator > _ring;
+
+    static constexpr std::uint64_t _pack(index_type index, std::uint64_t tag) noexcept
+    {
+      return (tag << 32) | index;
+    }
+
+    static constexpr index_type _index_of(std::uint64_t head) noexcept
+    {
+      return static_cast< index_type >(head);
+    }
+
+    index_type _index_of(const T* object) const noexcept
+    {
+      assert(( object >= &_objects[0] && object < &_objects[0] + _pool_size ));
+      return static_cast< index_type >(object - &_objects[0]);
+    }
+
+
+   public:
+    explicit pool_ring(size_type pool_size, size_type capacity, const allocator_type& alloc = allocator_type())
+      : _allocator(alloc)
+      , _link_allocator(_allocator)
+      , _pool_size(pool_size)
+      , _objects(_allocator.allocate(pool_size))
+      , _next(_link_allocator.allocate(pool_size))
+      , _free(_pack(pool_size != 0 ? 0 : nil, 0))
+      , _ring(pointer_allocator(_allocator))
+    {
+      assert(( pool_size < nil && capacity != 0 ));
+      for(size_type i = 0; i < pool_size; ++i) {
+        std::construct_at(&_objects[i]);
+        std::construct_at(&_next[i], i+1 < pool_size ? static_cast< index_type >(i+1) : nil);
+      }
+      _ring.reserve(capacity);
+    }
+
+    pool_ring(const pool_ring& other) = delete;
+    pool_ring& operator=(const pool_ring& other) = delete;
+
+    ~pool_ring()
+    {
+      std::destroy_n(&_objects[0], _pool_size);
+      std::destroy_n(_next, _pool_size);
+      _allocator.deallocate(_objects, _pool_size);
+      _link_allocator.deallocate(_next, _pool_size);
+    }
+
+    // Capacity
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _ring.empty();
+    }
+
+    size_type size() const noexcept
+    {
+      return _ring.size();
+    }
+
+    size_type capacity() const noexcept
+    {
+      return _ring.capacity();
+    }
+
+    size_type pool_size() const noexcept
+    {
+      return _pool_size;
+    }
+
+    // Pool, safe to call concurrently from any thread
+
+    pointer acquire() noexcept
+    {
+      std::uint64_t head = _free.load(std::memory_order_acquire);
+      while(_index_of(head) != nil) {
+        const index_type index = _index_of(head);
+        const index_type next = _next[index].load(std::memory_order_relaxed);
+        if(_free.compare_exchange_weak(head, _pack(next, (head >> 32) + 1), std::memory_order_acquire, std::memory_order_acquire)) {
+          return &_objects[index];
+        }
+      }
+      return nullptr;
+    }
+
+    void release(pointer object) noexcept
+    {
+      const index_type index = _index_of(object);
+      std::uint64_t head = _free.load(std::memory_order_relaxed);
+      do {
+        _next[index].store(_index_of(head), std::memory_order_relaxed);
+      } while(!_free.compare_exchange_weak(head, _pack(index, (head >> 32) + 1), std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    // Ring, single threaded
+
+    void publish(pointer object)
+    {
+      if(_ring.size() == _ring.capacity()) {
+        release(_ring.back());
+        _ring.pop_back();
+      }
+      _ring.push_back(object);
+    }
+
+    template< class Function >
+    bool consume(Function&& function)
+    {
+      if(_ring.empty()) {
+        return false;
+      }
+      pointer object = _ring.back();
+      _ring.pop_back();
+      function(*object);
+      release(object);
+      return true;
+    }
+
+    void clear() noexcept
+    {
+      while(!_ring.empty()) {
+        release(_ring.back());
+        _ring.pop_back();
+      }
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_POOL_RING
@@ -0,0 +1,214 @@
+// Independent reader cursors over a single circular buffer for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_READER_GROUP
+#define CIRCULAR_BUFFER_READER_GROUP
+
+#include "circular_buffer.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace anr
+{
+
+  template< class T, class Allocator = std::allocator< T > >
+  class reader_group
+  {
+   public:
+    typedef T                                                       value_type;
+    typedef Allocator                                               allocator_type;
+    typedef std::size_t                                             size_type;
+    typedef std::size_t                                             reader_id;
+    typedef typename circular_buffer< T, Allocator >::sequence_type sequence_type;
+
+
+   private:
+    struct reader
+    {
+      std::string name;
+      sequence_type position;
+      size_type overruns;
+      bool active;
+    };
+
+    circular_buffer< T, Allocator > _buffer;
+    std::vector< reader > _readers;
+    overrun_policy _policy;
+
+    sequence_type _oldest() const noexcept
+    {
+      return _buffer.next_sequence() - _buffer.size();
+    }
+
+    bool _blocked() const noexcept
+    {
+      if(_buffer.size() != _buffer.capacity()) {
+        return false;
+      }
+      for(const reader& r : _readers) {
+        if(r.active && r.position <= _oldest()) {
+          return true;
+        }
+      }
+      return false;
+    }
+
+    reader& _catch_up(reader_id id) noexcept
+    {
+      reader& r = _readers[id];
+      assert(( r.active ));
+      if(r.position < _oldest()) {
+        r.overruns += _oldest() - r.position;
+        r.position = _oldest();
+      }
+      return r;
+    }
+
+
+   public:
+    explicit reader_group(size_type capacity, overrun_policy policy = overrun_policy::block, const Allocator& alloc = Allocator())
+      : _buffer(alloc)
+      , _readers()
+      , _policy(policy)
+    {
+      _buffer.reserve(capacity);
+    }
+
+    // Capacity
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _buffer.empty();
+    }
+
+    size_type size() const noexcept
+    {
+      return _buffer.size();
+    }
+
+    size_type capacity() const noexcept
+    {
+      return _buffer.capacity();
+    }
+
+    // Readers
+
+    reader_id add_reader(std::string name)
+    {
+      for(reader_id id = 0; id < _readers.size(); ++id) {
+        if(!_readers[id].active) {
+          _readers[id] = reader{std::move(name), _oldest(), 0, true};
+          return id;
+        }
+      }
+      _readers.push_back(reader{std::move(name), _oldest(), 0, true});
+      return _readers.size() - 1;
+    }
+
+    std::optional< reader_id > find_reader(std::string_view name) const noexcept
+    {
+      for(reader_id id = 0; id < _readers.size(); ++id) {
+        if(_readers[id].active && _readers[id].name == name) {
+          return id;
+        }
+      }
+      return std::nullopt;
+    }
+
+    void remove_reader(reader_id id) noexcept
+    {
+      _readers[id].active = false;
+      _readers[id].name.clear();
+    }
+
+    size_type available(reader_id id) const noexcept
+    {
+      const reader& r = _readers[id];
+      assert(( r.active ));
+      return _buffer.next_sequence() - (r.position < _oldest() ? _oldest() : r.position);
+    }
+
+    size_type overruns(reader_id id) const noexcept
+    {
+      return _readers[id].overruns;
+    }
+
+    size_type read(reader_id id, std::span< T > out)
+    {
+      reader& r = _catch_up(id);
+      const size_type count = std::min< size_type >(out.size(), _buffer.next_sequence() - r.position);
+      for(size_type i = 0; i < count; ++i) {
+        out[i] = _buffer[typename circular_buffer< T, Allocator >::handle(r.position + i)];
+      }
+      r.position += count;
+      return count;
+    }
+
+    template< class Function >
+    size_type read(reader_id id, Function&& function, size_type count = std::numeric_limits< size_type >::max())
+    {
+      reader& r = _catch_up(id);
+      count = std::min< size_type >(count, _buffer.next_sequence() - r.position);
+      for(size_type i = 0; i < count; ++i) {
+        function(std::as_const(_buffer[typename circular_buffer< T, Allocator >::handle(r.position + i)]));
+      }
+      r.position += count;
+      return count;
+    }
+
+    // Modifiers
+
+    bool push(const T& value)
+    {
+      if(_policy == overrun_policy::block && _blocked()) {
+        return false;
+      }
+      _buffer.push_back(value);
+      return true;
+    }
+
+    bool push(T&& value)
+    {
+      if(_policy == overrun_policy::block && _blocked()) {
+        return false;
+      }
+      _buffer.push_back(std::move(value));
+      return true;
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_READER_GROUP
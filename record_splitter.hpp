@@ -0,0 +1,198 @@
+// Record splitter over a byte stream for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_RECORD_SPLITTER
+#define CIRCULAR_BUFFER_RECORD_SPLITTER
+
+#include "byte_stream.hpp"
+
+namespace anr
+{
+
+  namespace detail
+  {
+
+    // Calls function(offset) for each occurrence of c in [data, data + size), comparing 16 bytes
+    // at a time with SSE2 when available. Stops early when function returns false.
+    template< class Function >
+    bool for_each_byte(const char* data, std::size_t size, char c, Function&& function)
+    {
+      std::size_t i = 0;
+#ifdef CIRCULAR_BUFFER_SSE2
+      const __m128i needle = _mm_set1_epi8(c);
+      for(; i + 16 <= size; i += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast< const __m128i* >(data + i));
+        unsigned int mask = static_cast< unsigned int >(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, needle)));
+        while(mask != 0) {
+          if(!function(i + std::countr_zero(mask))) {
+            return false;
+          }
+          mask &= mask - 1;
+        }
+      }
+#endif
+      for(; i < size; ++i) {
+        if(data[i] == c && !function(i)) {
+          return false;
+        }
+      }
+      return true;
+    }
+
+  }
+
+  // A record that straddles the wrap point of the circular buffer is made of two parts.
+  struct record
+  {
+    std::string_view first;
+    std::string_view second;
+
+    std::size_t size() const noexcept
+    {
+      return first.size() + second.size();
+    }
+
+    bool contiguous() const noexcept
+    {
+      return second.empty();
+    }
+  };
+
+  // Splits the bytes of a byte stream into records ended by a delimiter. The records are views
+  // into the circular buffer, valid until they are consumed, and the bytes following the last
+  // delimiter are not scanned again when more bytes are written.
+  template< class Allocator = std::allocator< char > >
+  class record_splitter
+  {
+   public:
+    typedef std::size_t   size_type;
+
+
+   private:
+    byte_stream< Allocator >& _stream;
+    char _delimiter;
+    size_type _pending;
+    size_type _scanned;
+
+    record _record(size_type first, size_type last) const noexcept
+    {
+      const std::span< const char > one = _stream.array_one();
+      const std::span< const char > two = _stream.array_two();
+      if(last <= one.size()) {
+        return record{std::string_view(one.data() + first, last - first), std::string_view()};
+      }
+      if(first >= one.size()) {
+        return record{std::string_view(two.data() + (first - one.size()), last - first), std::string_view()};
+      }
+      return record{std::string_view(one.data() + first, one.size() - first), std::string_view(two.data(), last - one.size())};
+    }
+
+    // Calls function(offset) for the delimiters after the scanned bytes, stopping when it returns false.
+    template< class Function >
+    void _scan(Function&& function)
+    {
+      const std::span< const char > one = _stream.array_one();
+      const std::span< const char > two = _stream.array_two();
+      size_type from = _pending + _scanned;
+      bool more = true;
+      if(from < one.size()) {
+        more = detail::for_each_byte(one.data() + from, one.size() - from, _delimiter, [&](size_type offset) {
+          return function(from + offset);
+        });
+        from = one.size();
+      }
+      if(more && from < _stream.size()) {
+        const size_type skip = from - one.size();
+        detail::for_each_byte(two.data() + skip, two.size() - skip, _delimiter, [&](size_type offset) {
+          return function(from + offset);
+        });
+      }
+    }
+
+
+   public:
+    explicit record_splitter(byte_stream< Allocator >& stream, char delimiter = '\n')
+      : _stream(stream)
+      , _delimiter(delimiter)
+      , _pending(0)
+      , _scanned(0)
+    {
+    }
+
+    // Bytes of the records returned but not consumed yet, delimiters included.
+    size_type pending() const noexcept
+    {
+      return _pending;
+    }
+
+    // Returns the next record, without its delimiter, in out. Returns false if no complete
+    // record is available.
+    bool next(record& out)
+    {
+      bool found = false;
+      _scan([&](size_type offset) {
+        out = _record(_pending, offset);
+        _pending = offset + 1;
+        _scanned = 0;
+        found = true;
+        return false;
+      });
+      if(!found) {
+        _scanned = _stream.size() - _pending;
+      }
+      return found;
+    }
+
+    // Calls function(record) for the complete records available and returns their number.
+    template< class Function >
+    size_type for_each(Function&& function)
+    {
+      size_type count = 0;
+      _scan([&](size_type offset) {
+        const record r = _record(_pending, offset);
+        function(r);
+        _pending = offset + 1;
+        count ++;
+        return true;
+      });
+      _scanned = _stream.size() - _pending;
+      return count;
+    }
+
+    // Consumes all the records returned so far from the byte stream.
+    void consume()
+    {
+      _stream.consume(_pending);
+      _pending = 0;
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_RECORD_SPLITTER
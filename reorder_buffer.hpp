@@ -0,0 +1,223 @@
+// Reorder buffer for out-of-order arrivals for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_REORDER_BUFFER
+#define CIRCULAR_BUFFER_REORDER_BUFFER
+
+#include "occupancy_bitmap.hpp"
+
+#include <chrono>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace anr
+{
+
+  // The packet of sequence number seq waits in the slot seq % capacity, the occupancy bitmap
+  // telling which slots are filled. The release scans the bitmap for the end of the contiguous
+  // prefix and delivers it as a batch. A hole at the head of the window is declared lost once the
+  // first packet waiting behind it has waited for the timeout.
+  template< class T, class Clock = std::chrono::steady_clock >
+  class reorder_buffer
+  {
+   public:
+    typedef T                             value_type;
+    typedef std::size_t                   size_type;
+    typedef std::uint64_t                 sequence_type;
+    typedef typename Clock::time_point    time_point;
+    typedef typename Clock::duration      duration;
+
+
+   private:
+    struct slot
+    {
+      std::optional< T > value;
+      time_point arrival;
+    };
+
+    std::vector< slot > _slots;
+    occupancy_bitmap _occupied;
+    duration _timeout;
+    sequence_type _next;
+    size_type _count;
+
+    slot& _slot(sequence_type seq) noexcept
+    {
+      return _slots[seq % _slots.size()];
+    }
+
+    template< class Function >
+    void _deliver(sequence_type seq, Function& deliver)
+    {
+      slot& s = _slot(seq);
+      _occupied.reset(seq);
+      _count --;
+      deliver(seq, std::move(*s.value));
+      s.value.reset();
+    }
+
+    template< class... Args >
+    bool _insert(sequence_type seq, time_point now, Args&&... args)
+    {
+      if(seq < _next || seq - _next >= _slots.size() || _occupied.test(seq)) {
+        return false;
+      }
+      slot& s = _slot(seq);
+      s.value.emplace(std::forward< Args >(args)...);
+      s.arrival = now;
+      _occupied.set(seq);
+      _count ++;
+      return true;
+    }
+
+
+   public:
+    explicit reorder_buffer(size_type capacity, duration timeout, sequence_type first = 0)
+      : _slots(capacity)
+      , _occupied(capacity)
+      , _timeout(timeout)
+      , _next(first)
+      , _count(0)
+    {
+      assert(( capacity != 0 ));
+    }
+
+    // Capacity
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _count == 0;
+    }
+
+    // Number of packets waiting.
+    size_type size() const noexcept
+    {
+      return _count;
+    }
+
+    size_type capacity() const noexcept
+    {
+      return _slots.size();
+    }
+
+    // Sequence number of the next packet to deliver.
+    sequence_type next_sequence() const noexcept
+    {
+      return _next;
+    }
+
+    duration timeout() const noexcept
+    {
+      return _timeout;
+    }
+
+    // Modifiers
+
+    // Returns false and does nothing if the packet was already delivered or declared lost, is
+    // already waiting, or is beyond the window [next_sequence(), next_sequence() + capacity()).
+    bool insert(sequence_type seq, const T& value, time_point now)
+    {
+      return _insert(seq, now, value);
+    }
+
+    bool insert(sequence_type seq, T&& value, time_point now)
+    {
+      return _insert(seq, now, std::move(value));
+    }
+
+    // Calls deliver(seq, value) for the contiguous prefix of waiting packets and returns their number.
+    template< class Deliver >
+    size_type release(Deliver&& deliver)
+    {
+      const sequence_type first = _next;
+      sequence_type last = _occupied.find_unset(first, first + _slots.size());
+      if(last == occupancy_bitmap::npos) {
+        last = first + _slots.size();
+      }
+      for(; _next != last; ++_next) {
+        _deliver(_next, deliver);
+      }
+      return last - first;
+    }
+
+    // Releases the contiguous prefix, skipping the holes that timed out at now, for which
+    // lost(first, last) is called with the range of missing sequence numbers.
+    template< class Deliver, class Lost >
+    size_type poll(time_point now, Deliver&& deliver, Lost&& lost)
+    {
+      size_type released = release(deliver);
+      while(_count != 0) {
+        const sequence_type waiting = _occupied.find_set(_next, _next + _slots.size());
+        if(now - _slot(waiting).arrival < _timeout) {
+          break;
+        }
+        lost(_next, waiting);
+        _next = waiting;
+        released += release(deliver);
+      }
+      return released;
+    }
+
+    // Moves the head of the window to seq, delivering the packets waiting before it and
+    // declaring the holes lost.
+    template< class Deliver, class Lost >
+    void advance(sequence_type seq, Deliver&& deliver, Lost&& lost)
+    {
+      while(_next < seq) {
+        const sequence_type last = seq - _next < _slots.size() ? seq : _next + _slots.size();
+        const sequence_type waiting = _count != 0 ? _occupied.find_set(_next, last) : occupancy_bitmap::npos;
+        if(waiting == occupancy_bitmap::npos) {
+          lost(_next, seq);
+          _next = seq;
+          break;
+        }
+        if(waiting != _next) {
+          lost(_next, waiting);
+        }
+        _deliver(waiting, deliver);
+        _next = waiting + 1;
+      }
+    }
+
+    // Drops the waiting packets, the window starting again at first.
+    void reset(sequence_type first)
+    {
+      for(auto& s : _slots) {
+        s.value.reset();
+      }
+      _occupied.clear();
+      _next = first;
+      _count = 0;
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_REORDER_BUFFER
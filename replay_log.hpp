@@ -0,0 +1,164 @@
+// Event-sourcing replay log with snapshot compaction for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_REPLAY_LOG
+#define CIRCULAR_BUFFER_REPLAY_LOG
+
+#include "circular_buffer.hpp"
+
+#include <cstdint>
+#include <utility>
+
+namespace anr
+{
+
+  template< class Event, class State, class Apply, class Allocator = std::allocator< Event > >
+  class replay_log
+  {
+   public:
+    typedef Event         event_type;
+    typedef State         state_type;
+    typedef Apply         apply_type;
+    typedef std::size_t   size_type;
+    typedef std::uint64_t sequence_type;
+
+
+   private:
+    circular_buffer< Event, Allocator > _tail;
+    State _snapshot;
+    Apply _apply;
+    size_type _compaction;
+    sequence_type _snapshot_sequence;
+
+    void _fold(size_type count)
+    {
+      for(size_type i = 0; i < count && !_tail.empty(); ++i) {
+        _apply(_snapshot, _tail.back());
+        _tail.pop_back();
+        _snapshot_sequence ++;
+      }
+    }
+
+    void _make_room()
+    {
+      if(_tail.size() == _tail.capacity()) {
+        _fold(_compaction);
+      }
+    }
+
+
+   public:
+    explicit replay_log(size_type capacity, State initial = State(), Apply apply = Apply(), size_type compaction = 0, const Allocator& alloc = Allocator())
+      : _tail(alloc)
+      , _snapshot(std::move(initial))
+      , _apply(std::move(apply))
+      , _compaction(compaction != 0 ? compaction : (capacity / 4 != 0 ? capacity / 4 : 1))
+      , _snapshot_sequence(0)
+    {
+      assert(( capacity != 0 && _compaction <= capacity ));
+      _tail.reserve(capacity);
+    }
+
+    // Capacity
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _tail.empty();
+    }
+
+    size_type size() const noexcept
+    {
+      return _tail.size();
+    }
+
+    size_type capacity() const noexcept
+    {
+      return _tail.capacity();
+    }
+
+    // Sequence numbers
+
+    sequence_type snapshot_sequence() const noexcept
+    {
+      return _snapshot_sequence;
+    }
+
+    sequence_type next_sequence() const noexcept
+    {
+      return _snapshot_sequence + _tail.size();
+    }
+
+    // Modifiers
+
+    sequence_type append(const Event& event)
+    {
+      _make_room();
+      _tail.push_back(event);
+      return next_sequence() - 1;
+    }
+
+    sequence_type append(Event&& event)
+    {
+      _make_room();
+      _tail.push_back(std::move(event));
+      return next_sequence() - 1;
+    }
+
+    void compact()
+    {
+      _fold(_tail.size());
+    }
+
+    // Recovery
+
+    const State& snapshot() const noexcept
+    {
+      return _snapshot;
+    }
+
+    template< class Function >
+    void replay(Function&& function, sequence_type from = 0) const
+    {
+      const sequence_type first = from > _snapshot_sequence ? from : _snapshot_sequence;
+      for(sequence_type seq = first; seq < next_sequence(); ++seq) {
+        function(_tail[next_sequence() - 1 - seq]);
+      }
+    }
+
+    State recover() const
+    {
+      State state = _snapshot;
+      replay([&](const Event& event) { _apply(state, event); });
+      return state;
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_REPLAY_LOG
@@ -0,0 +1,303 @@
+// Circular buffer with segmented storage for huge capacities for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_SEGMENTED_BUFFER
+#define CIRCULAR_BUFFER_SEGMENTED_BUFFER
+
+#include "circular_buffer.hpp"
+
+#include <bit>
+#include <new>
+
+namespace anr
+{
+
+  template< class T >
+  inline constexpr std::size_t default_chunk_size = sizeof(T) < 4096 ? std::bit_floor(4096 / sizeof(T)) : 1;
+
+  // The elements are stored in fixed-size chunks allocated on demand. The chunk table is
+  // itself a circular buffer whose front is the chunk holding the newest element and whose
+  // back is the chunk holding the oldest one.
+  template< class T, std::size_t ChunkSize = default_chunk_size< T > >
+  class segmented_buffer
+  {
+    static_assert(ChunkSize != 0 && std::has_single_bit(ChunkSize), "The chunk size of a segmented_buffer must be a power of two");
+
+   public:
+    typedef T             value_type;
+    typedef std::size_t   size_type;
+    typedef T&            reference;
+    typedef const T&      const_reference;
+    typedef T*            pointer;
+
+
+   private:
+    static constexpr size_type _shift = std::countr_zero(ChunkSize);
+    static constexpr size_type _mask = ChunkSize - 1;
+    static constexpr std::align_val_t _alignment = std::align_val_t(ChunkSize * sizeof(T) < 4096 ? alignof(T) : 4096);
+
+    circular_buffer< pointer > _chunks;
+    pointer _spare;
+    size_type _first;
+    size_type _size;
+    size_type _capacity;
+
+    static pointer _allocate_chunk()
+    {
+      return static_cast< pointer >(::operator new(ChunkSize * sizeof(T), _alignment));
+    }
+
+    static void _deallocate_chunk(pointer chunk) noexcept
+    {
+      ::operator delete(chunk, _alignment);
+    }
+
+    static constexpr size_type _chunk_count(size_type capacity) noexcept
+    {
+      // A partially filled chunk can be found at both ends of the buffer.
+      return ((capacity + _mask) >> _shift) + 1;
+    }
+
+    pointer _address(size_type offset) const noexcept
+    {
+      const size_type global = _first + offset;
+      return &_chunks[_chunks.size() - 1 - (global >> _shift)][global & _mask];
+    }
+
+    void _release_chunk(pointer chunk) noexcept
+    {
+      if(_spare == nullptr) {
+        _spare = chunk;
+      }
+      else {
+        _deallocate_chunk(chunk);
+      }
+    }
+
+    void _add_chunk()
+    {
+      pointer chunk = _spare != nullptr ? _spare : _allocate_chunk();
+      _spare = nullptr;
+      if(_chunks.size() == _chunks.capacity()) {
+        _chunks.reserve(2 * _chunks.capacity());
+      }
+      _chunks.push_back(chunk);
+    }
+
+    static void check_out_of_range(size_type pos, size_type size)
+    {
+      if(pos >= size) {
+        char buffer[256];
+        std::snprintf(buffer, 256, "The position %lu exceeds the circular buffer size (%lu)", pos, size);
+        throw std::out_of_range(buffer);
+      }
+    }
+
+
+   public:
+    explicit segmented_buffer(size_type capacity = 0)
+      : _chunks()
+      , _spare(nullptr)
+      , _first(0)
+      , _size(0)
+      , _capacity(capacity)
+    {
+      _chunks.reserve(_chunk_count(capacity));
+    }
+
+    segmented_buffer(const segmented_buffer& other) = delete;
+    segmented_buffer& operator=(const segmented_buffer& other) = delete;
+
+    ~segmented_buffer()
+    {
+      clear();
+      while(!_chunks.empty()) {
+        _deallocate_chunk(_chunks.back());
+        _chunks.pop_back();
+      }
+      if(_spare != nullptr) {
+        _deallocate_chunk(_spare);
+      }
+    }
+
+    // Element access
+
+    reference at(size_type pos)
+    {
+      check_out_of_range(pos, _size);
+      return operator[](pos);
+    }
+
+    const_reference at(size_type pos) const
+    {
+      check_out_of_range(pos, _size);
+      return operator[](pos);
+    }
+
+    reference operator[](size_type pos) noexcept
+    {
+      return *_address(_size - 1 - pos);
+    }
+
+    const_reference operator[](size_type pos) const noexcept
+    {
+      return *_address(_size - 1 - pos);
+    }
+
+    reference front()
+    {
+      assert((_size != 0));
+      return operator[](0);
+    }
+
+    const_reference front() const
+    {
+      assert((_size != 0));
+      return operator[](0);
+    }
+
+    reference back()
+    {
+      assert((_size != 0));
+      return *_address(0);
+    }
+
+    const_reference back() const
+    {
+      assert((_size != 0));
+      return *_address(0);
+    }
+
+    // Capacity
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _size == 0;
+    }
+
+    size_type size() const noexcept
+    {
+      return _size;
+    }
+
+    size_type capacity() const noexcept
+    {
+      return _capacity;
+    }
+
+    size_type chunk_count() const noexcept
+    {
+      return _chunks.size() + (_spare != nullptr ? 1 : 0);
+    }
+
+    void reserve(size_type new_cap)
+    {
+      while(_size > new_cap) {
+        pop_back();
+      }
+      _capacity = new_cap;
+      if(_chunks.capacity() < _chunk_count(new_cap)) {
+        _chunks.reserve(_chunk_count(new_cap));
+      }
+    }
+
+    void shrink_to_fit()
+    {
+      if(_spare != nullptr) {
+        _deallocate_chunk(_spare);
+        _spare = nullptr;
+      }
+    }
+
+    // Modifiers
+
+    void clear() noexcept
+    {
+      while(!empty()) {
+        pop_back();
+      }
+    }
+
+    void push_back(const_reference value)
+    {
+      emplace_back(value);
+    }
+
+    void push_back(T&& value)
+    {
+      emplace_back(std::move(value));
+    }
+
+    template< class... Args >
+    reference emplace_back(Args&&... args)
+    {
+      assert((_capacity != 0));
+      if(_size == _capacity) {
+        pop_back();
+      }
+      if(((_first + _size) >> _shift) == _chunks.size()) {
+        _add_chunk();
+      }
+      pointer p = _address(_size);
+      std::construct_at(p, std::forward< Args >(args)...);
+      _size ++;
+      return *p;
+    }
+
+    void pop_front()
+    {
+      assert((_size != 0));
+      _size --;
+      std::destroy_at(_address(_size));
+      if(((_first + _size) & _mask) == 0) {
+        _release_chunk(_chunks.front());
+        _chunks.pop_front();
+        if(_chunks.empty()) {
+          _first = 0;
+        }
+      }
+    }
+
+    void pop_back()
+    {
+      assert((_size != 0));
+      std::destroy_at(_address(0));
+      _first ++;
+      _size --;
+      if(_first == ChunkSize || _size == 0) {
+        _release_chunk(_chunks.back());
+        _chunks.pop_back();
+        _first = 0;
+      }
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_SEGMENTED_BUFFER
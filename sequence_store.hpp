@@ -0,0 +1,292 @@
+// Sequence-numbered message store with gap tracking for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_SEQUENCE_STORE
+#define CIRCULAR_BUFFER_SEQUENCE_STORE
+
+#include "circular_buffer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace anr
+{
+
+  // Keeps the messages of the last capacity sequence numbers of a feed, the newest slot of the
+  // circular buffer holding the highest sequence number received. The gaps are tracked by a
+  // two-level bitmap: one bit per slot telling whether its message was received, and one bit per
+  // word of the first level telling whether the word may have a gap, so that the scans skip the
+  // complete parts of the window 64 or 4096 sequence numbers at a time.
+  template< class T, class Allocator = std::allocator< std::optional< T > > >
+  class sequence_store
+  {
+   public:
+    typedef T               value_type;
+    typedef Allocator       allocator_type;
+    typedef std::size_t     size_type;
+    typedef std::uint64_t   sequence_type;
+
+    static constexpr sequence_type npos = std::numeric_limits< sequence_type >::max();
+
+
+   private:
+    circular_buffer< std::optional< T >, Allocator > _ring;
+    std::vector< std::uint64_t > _received;
+    std::vector< std::uint64_t > _incomplete;
+    size_type _mask;
+    size_type _count;
+    sequence_type _end;
+
+    static constexpr std::uint64_t full_word = std::numeric_limits< std::uint64_t >::max();
+
+    std::optional< T >& _slot(sequence_type seq) noexcept
+    {
+      return _ring[_end - 1 - seq];
+    }
+
+    const std::optional< T >& _slot(sequence_type seq) const noexcept
+    {
+      return _ring[_end - 1 - seq];
+    }
+
+    void _mark(sequence_type seq) noexcept
+    {
+      const size_type slot = seq & _mask;
+      std::uint64_t& word = _received[slot / 64];
+      word |= std::uint64_t(1) << (slot % 64);
+      if(word == full_word) {
+        _incomplete[slot / 4096] &= ~(std::uint64_t(1) << (slot / 64 % 64));
+      }
+    }
+
+    void _unmark(sequence_type seq) noexcept
+    {
+      const size_type slot = seq & _mask;
+      _received[slot / 64] &= ~(std::uint64_t(1) << (slot % 64));
+      _incomplete[slot / 4096] |= std::uint64_t(1) << (slot / 64 % 64);
+    }
+
+    // Returns the first sequence number in [first, last) whose message was received (Missing is false)
+    // or not (Missing is true), or npos.
+    template< bool Missing >
+    sequence_type _find(sequence_type first, sequence_type last) const noexcept
+    {
+      const size_type group = std::min< size_type >(_mask + 1, 4096);
+      while(first < last) {
+        const size_type slot = first & _mask;
+        if constexpr(Missing) {
+          if(slot % group == 0 && _incomplete[slot / 4096] == 0) {
+            first += group;
+            continue;
+          }
+        }
+        const std::uint64_t word = (Missing ? ~_received[slot / 64] : _received[slot / 64]) >> (slot % 64);
+        if(word != 0) {
+          const sequence_type found = first + std::countr_zero(word);
+          return found < last ? found : npos;
+        }
+        first += 64 - slot % 64;
+      }
+      return npos;
+    }
+
+    // Extends the window up to seq, the new slots being empty.
+    void _advance(sequence_type seq)
+    {
+      if(seq - _end >= _ring.capacity()) {
+        _ring.clear();
+        _count = 0;
+        _end = seq + 1 - _ring.capacity();
+      }
+      while(_end <= seq) {
+        if(_ring.size() == _ring.capacity() && _ring.back().has_value()) {
+          _count --;
+        }
+        _ring.push_back(std::nullopt);
+        _unmark(_end++);
+      }
+    }
+
+
+   public:
+    explicit sequence_store(size_type capacity, sequence_type first = 0, const Allocator& alloc = Allocator())
+      : _ring(alloc)
+      , _received()
+      , _incomplete()
+      , _mask(std::bit_ceil< size_type >(capacity > 64 ? capacity : 64) - 1)
+      , _count(0)
+      , _end(first)
+    {
+      assert(( capacity != 0 ));
+      _ring.reserve(capacity);
+      _received.assign((_mask + 1) / 64, 0);
+      _incomplete.assign((_mask + 4096) / 4096, full_word);
+    }
+
+    // Element access
+
+    // Returns the message of sequence number seq, or nullptr if it is not in the store.
+    const T* find(sequence_type seq) const noexcept
+    {
+      if(!in_window(seq)) {
+        return nullptr;
+      }
+      const std::optional< T >& slot = _slot(seq);
+      return slot ? &*slot : nullptr;
+    }
+
+    bool contains(sequence_type seq) const noexcept
+    {
+      return find(seq) != nullptr;
+    }
+
+    // Calls function(seq, message) for the messages received in [first, last), in order,
+    // and returns their number.
+    template< class Function >
+    size_type for_range(sequence_type first, sequence_type last, Function&& function) const
+    {
+      first = std::max(first, first_sequence());
+      last = std::min(last, _end);
+      size_type count = 0;
+      for(sequence_type seq = _find< false >(first, last); seq != npos; seq = _find< false >(seq + 1, last)) {
+        function(seq, *_slot(seq));
+        count ++;
+      }
+      return count;
+    }
+
+    // Gaps
+
+    // Returns the first sequence number of [first, last) in the window whose message is missing, or npos.
+    sequence_type find_gap(sequence_type first, sequence_type last) const noexcept
+    {
+      first = std::max(first, first_sequence());
+      last = std::min(last, _end);
+      return first < last ? _find< true >(first, last) : npos;
+    }
+
+    // Calls function(gap_first, gap_last) for the ranges of missing sequence numbers of
+    // [first, last) in the window.
+    template< class Function >
+    void for_each_gap(sequence_type first, sequence_type last, Function&& function) const
+    {
+      last = std::min(last, _end);
+      for(sequence_type gap = find_gap(first, last); gap != npos; ) {
+        const sequence_type received = _find< false >(gap, last);
+        const sequence_type gap_last = received != npos ? received : last;
+        function(gap, gap_last);
+        gap = gap_last < last ? _find< true >(gap_last, last) : npos;
+      }
+    }
+
+    // Capacity
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _count == 0;
+    }
+
+    // Number of messages in the store.
+    size_type size() const noexcept
+    {
+      return _count;
+    }
+
+    size_type capacity() const noexcept
+    {
+      return _ring.capacity();
+    }
+
+    // Window
+
+    sequence_type first_sequence() const noexcept
+    {
+      return _end - _ring.size();
+    }
+
+    // One past the highest sequence number received.
+    sequence_type next_sequence() const noexcept
+    {
+      return _end;
+    }
+
+    bool in_window(sequence_type seq) const noexcept
+    {
+      return seq - first_sequence() < _ring.size();
+    }
+
+    // Modifiers
+
+    // Stores the message of sequence number seq. A sequence number beyond the window slides it,
+    // the oldest messages being dropped. Returns false and does nothing if seq precedes the window
+    // or its message was already received.
+    bool insert(sequence_type seq, const T& value)
+    {
+      return emplace(seq, value);
+    }
+
+    bool insert(sequence_type seq, T&& value)
+    {
+      return emplace(seq, std::move(value));
+    }
+
+    template< class... Args >
+    bool emplace(sequence_type seq, Args&&... args)
+    {
+      if(seq < first_sequence()) {
+        return false;
+      }
+      if(seq >= _end) {
+        _advance(seq);
+      }
+      std::optional< T >& slot = _slot(seq);
+      if(slot) {
+        return false;
+      }
+      slot.emplace(std::forward< Args >(args)...);
+      _mark(seq);
+      _count ++;
+      return true;
+    }
+
+    // Empties the store, the window starting again at first.
+    void reset(sequence_type first)
+    {
+      _ring.clear();
+      _count = 0;
+      _end = first;
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_SEQUENCE_STORE
@@ -0,0 +1,238 @@
+// Circular buffer with copy-on-write snapshots for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_SNAPSHOT_BUFFER
+#define CIRCULAR_BUFFER_SNAPSHOT_BUFFER
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <memory>
+#include <vector>
+
+namespace anr
+{
+
+  // The storage is split in fixed-size blocks shared through reference counting: a
+  // snapshot only copies the block table, and the live buffer copies a block before
+  // writing into it if a snapshot still refers to it.
+  template< class T, std::size_t BlockSize = 4096 / sizeof(T) >
+  class snapshot_buffer
+  {
+    static_assert(BlockSize != 0 && std::has_single_bit(BlockSize), "The block size of a snapshot_buffer must be a power of two");
+
+   public:
+    typedef T             value_type;
+    typedef std::size_t   size_type;
+    typedef T&            reference;
+    typedef const T&      const_reference;
+
+    class snapshot;
+
+
+   private:
+    typedef std::array< T, BlockSize > block;
+
+    static constexpr size_type _shift = std::countr_zero(BlockSize);
+    static constexpr size_type _mask = BlockSize - 1;
+
+    std::vector< std::shared_ptr< block > > _blocks;
+    size_type _index;
+    size_type _size;
+    size_type _capacity;
+
+    size_type _slot(size_type pos) const noexcept
+    {
+      return (_index + _capacity - pos) % _capacity;
+    }
+
+    const_reference _get(size_type slot) const noexcept
+    {
+      return (*_blocks[slot >> _shift])[slot & _mask];
+    }
+
+    reference _write(size_type slot)
+    {
+      std::shared_ptr< block >& b = _blocks[slot >> _shift];
+      if(b.use_count() > 1) {
+        b = std::make_shared< block >(*b);
+      }
+      else {
+        // use_count is a relaxed load: the fence orders the write after the reads of a snapshot
+        // released by another thread.
+        std::atomic_thread_fence(std::memory_order_acquire);
+      }
+      return (*b)[slot & _mask];
+    }
+
+
+   public:
+    explicit snapshot_buffer(size_type capacity)
+      : _blocks((capacity + _mask) >> _shift)
+      , _index(capacity-1)
+      , _size(0)
+      , _capacity(capacity)
+    {
+      for(auto& b : _blocks) {
+        b = std::make_shared< block >();
+      }
+    }
+
+    // Element access
+
+    const_reference operator[](size_type pos) const noexcept
+    {
+      return _get(_slot(pos));
+    }
+
+    const_reference front() const
+    {
+      assert((_size != 0));
+      return _get(_index);
+    }
+
+    const_reference back() const
+    {
+      assert((_size != 0));
+      return operator[](_size-1);
+    }
+
+    // Capacity
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _size == 0;
+    }
+
+    size_type size() const noexcept
+    {
+      return _size;
+    }
+
+    size_type capacity() const noexcept
+    {
+      return _capacity;
+    }
+
+    // Modifiers
+
+    void clear() noexcept
+    {
+      _index = _capacity-1;
+      _size = 0;
+    }
+
+    void push_back(const_reference value)
+    {
+      _index = (_index + 1) % _capacity;
+      _write(_index) = value;
+      if(_size != _capacity) {
+        _size ++;
+      }
+    }
+
+    void push_back(T&& value)
+    {
+      _index = (_index + 1) % _capacity;
+      _write(_index) = std::move(value);
+      if(_size != _capacity) {
+        _size ++;
+      }
+    }
+
+    void pop_back()
+    {
+      assert((_size != 0));
+      _size --;
+    }
+
+    // Snapshots
+
+    snapshot take_snapshot() const
+    {
+      return snapshot(*this);
+    }
+
+  };
+
+
+
+  template< class T, std::size_t BlockSize >
+  class snapshot_buffer< T, BlockSize >::snapshot
+  {
+   private:
+    std::vector< std::shared_ptr< const block > > _blocks;
+    size_type _index;
+    size_type _size;
+    size_type _capacity;
+
+    explicit snapshot(const snapshot_buffer& parent)
+      : _blocks(parent._blocks.begin(), parent._blocks.end())
+      , _index(parent._index)
+      , _size(parent._size)
+      , _capacity(parent._capacity)
+    {
+    }
+
+   public:
+    friend snapshot_buffer;
+
+    const_reference operator[](size_type pos) const noexcept
+    {
+      const size_type slot = (_index + _capacity - pos) % _capacity;
+      return (*_blocks[slot >> _shift])[slot & _mask];
+    }
+
+    const_reference front() const
+    {
+      assert((_size != 0));
+      return operator[](0);
+    }
+
+    const_reference back() const
+    {
+      assert((_size != 0));
+      return operator[](_size-1);
+    }
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _size == 0;
+    }
+
+    size_type size() const noexcept
+    {
+      return _size;
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_SNAPSHOT_BUFFER
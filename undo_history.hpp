@@ -0,0 +1,151 @@
+// Bounded undo/redo history for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+
+#ifndef CIRCULAR_BUFFER_UNDO_HISTORY
+#define CIRCULAR_BUFFER_UNDO_HISTORY
+
+#include "circular_buffer.hpp"
+
+#include <utility>
+
+namespace anr
+{
+
+  template< class Delta, class Allocator = std::allocator< Delta > >
+  class undo_history
+  {
+   public:
+    typedef Delta         value_type;
+    typedef Allocator     allocator_type;
+    typedef std::size_t   size_type;
+
+
+   private:
+    // The newest deltas, at the front of the buffer, are the ones that have been undone.
+    circular_buffer< Delta, Allocator > _history;
+    size_type _redo;
+
+    void _drop_redo()
+    {
+      for(; _redo != 0; --_redo) {
+        _history.pop_front();
+      }
+      if(_history.size() == _history.capacity()) {
+        _history.pop_back();
+      }
+    }
+
+
+   public:
+    explicit undo_history(size_type depth, const Allocator& alloc = Allocator())
+      : _history(alloc)
+      , _redo(0)
+    {
+      assert(( depth != 0 ));
+      _history.reserve(depth);
+    }
+
+    // Capacity
+
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _history.empty();
+    }
+
+    size_type depth() const noexcept
+    {
+      return _history.capacity();
+    }
+
+    size_type undo_count() const noexcept
+    {
+      return _history.size() - _redo;
+    }
+
+    size_type redo_count() const noexcept
+    {
+      return _redo;
+    }
+
+    bool can_undo() const noexcept
+    {
+      return undo_count() != 0;
+    }
+
+    bool can_redo() const noexcept
+    {
+      return _redo != 0;
+    }
+
+    // Modifiers
+
+    void record(const Delta& delta)
+    {
+      _drop_redo();
+      _history.push_back(delta);
+    }
+
+    void record(Delta&& delta)
+    {
+      _drop_redo();
+      _history.push_back(std::move(delta));
+    }
+
+    template< class Function >
+    bool undo(Function&& revert)
+    {
+      if(!can_undo()) {
+        return false;
+      }
+      revert(std::as_const(_history[_redo]));
+      _redo ++;
+      return true;
+    }
+
+    template< class Function >
+    bool redo(Function&& apply)
+    {
+      if(!can_redo()) {
+        return false;
+      }
+      _redo --;
+      apply(std::as_const(_history[_redo]));
+      return true;
+    }
+
+    void clear() noexcept
+    {
+      _history.clear();
+      _redo = 0;
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_UNDO_HISTORY
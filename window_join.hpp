@@ -0,0 +1,212 @@
+// Symmetric hash window join over two circular buffers for C+20
+// version 1.0.0
+// https://github.com/AnRoyer/circular_buffer
+//
+// Licensed under the MIT License <http://opensource.org/licenses/MIT>.
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2023 Anthony Royer
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#ifndef CIRCULAR_BUFFER_WINDOW_JOIN
+#define CIRCULAR_BUFFER_WINDOW_JOIN
+
+#include "circular_buffer.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
+namespace anr
+{
+
+  template< class Key, class Left, class Right, class Timestamp = std::int64_t, class Hash = std::hash< Key >, class KeyEqual = std::equal_to< Key > >
+  class window_join
+  {
+   public:
+    typedef Key           key_type;
+    typedef Left          left_type;
+    typedef Right         right_type;
+    typedef Timestamp     timestamp_type;
+    typedef std::size_t   size_type;
+
+
+   private:
+    typedef std::uint64_t sequence_type;
+
+    static constexpr sequence_type npos = std::numeric_limits< sequence_type >::max();
+
+    // Entries of a same key are chained through their sequence number, oldest first,
+    // so that a probe only visits the entries of the matching key.
+    template< class Value >
+    class side
+    {
+      struct entry
+      {
+        Key key;
+        Timestamp time;
+        Value value;
+        sequence_type next;
+      };
+
+      struct chain
+      {
+        sequence_type first;
+        sequence_type last;
+      };
+
+      circular_buffer< entry > _ring;
+      std::unordered_map< Key, chain, Hash, KeyEqual > _index;
+      sequence_type _tail;
+
+      entry& _at(sequence_type seq)
+      {
+        return _ring[_tail - 1 - seq];
+      }
+
+     public:
+      explicit side(size_type capacity)
+        : _ring()
+        , _index()
+        , _tail(0)
+      {
+        _ring.reserve(capacity != 0 ? capacity : 1);
+      }
+
+      size_type size() const noexcept
+      {
+        return _ring.size();
+      }
+
+      void insert(const Key& key, Timestamp time, const Value& value)
+      {
+        assert(( _ring.empty() || !(time < _ring.front().time) ));
+        if(_ring.size() == _ring.capacity()) {
+          _ring.reserve(2 * _ring.capacity());
+        }
+
+        const sequence_type seq = _tail++;
+        _ring.push_back(entry{key, time, value, npos});
+
+        auto it = _index.find(key);
+        if(it == _index.end()) {
+          _index.emplace(key, chain{seq, seq});
+        }
+        else {
+          _at(it->second.last).next = seq;
+          it->second.last = seq;
+        }
+      }
+
+      void expire(Timestamp limit)
+      {
+        while(!_ring.empty() && _ring.back().time < limit) {
+          const entry& oldest = _ring.back();
+          auto it = _index.find(oldest.key);
+          assert(( it != _index.end() ));
+          if(oldest.next == npos) {
+            _index.erase(it);
+          }
+          else {
+            it->second.first = oldest.next;
+          }
+          _ring.pop_back();
+        }
+      }
+
+      template< class Function >
+      void probe(const Key& key, Timestamp lower, Timestamp upper, Function&& function)
+      {
+        auto it = _index.find(key);
+        if(it == _index.end()) {
+          return;
+        }
+        for(sequence_type seq = it->second.first; seq != npos; ) {
+          const entry& e = _at(seq);
+          if(upper < e.time) {
+            break;
+          }
+          if(!(e.time < lower)) {
+            function(e.value);
+          }
+          seq = e.next;
+        }
+      }
+    };
+
+    Timestamp _window;
+    side< Left > _left;
+    side< Right > _right;
+
+
+   public:
+    explicit window_join(Timestamp window, size_type capacity = 1024)
+      : _window(window)
+      , _left(capacity)
+      , _right(capacity)
+    {
+    }
+
+    Timestamp window() const noexcept
+    {
+      return _window;
+    }
+
+    size_type left_size() const noexcept
+    {
+      return _left.size();
+    }
+
+    size_type right_size() const noexcept
+    {
+      return _right.size();
+    }
+
+    template< class Callback >
+    void push_left(const Key& key, Timestamp time, const Left& value, Callback&& on_match)
+    {
+      _right.expire(time - _window);
+      _right.probe(key, time - _window, time + _window, [&](const Right& right) {
+        on_match(key, value, right);
+      });
+      _left.insert(key, time, value);
+    }
+
+    template< class Callback >
+    void push_right(const Key& key, Timestamp time, const Right& value, Callback&& on_match)
+    {
+      _left.expire(time - _window);
+      _left.probe(key, time - _window, time + _window, [&](const Left& left) {
+        on_match(key, left, value);
+      });
+      _right.insert(key, time, value);
+    }
+
+    void expire(Timestamp watermark)
+    {
+      _left.expire(watermark - _window);
+      _right.expire(watermark - _window);
+    }
+
+  };
+
+}
+
+#endif // CIRCULAR_BUFFER_WINDOW_JOIN